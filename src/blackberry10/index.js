@@ -23,6 +23,9 @@
 
 var g11n;
 
+// Streamed batch commands waiting for events, by callback id.
+var streams = {};
+
 var globalization = {
     /**
     * Returns the string identifier for the client's current language.
@@ -243,6 +246,7 @@ var globalization = {
             result.ok({
                 pattern: data.result.pattern,
                 timezone: data.result.timezone,
+                iana_timezone: data.result.iana_timezone,
                 utc_offset: data.result.utc_offset,
                 dst_offset: data.result.dst_offset
             });
@@ -553,6 +557,276 @@ var globalization = {
                 grouping: data.result.grouping
             });
         }
+    },
+
+    /**
+    * Formats an array of dates with one set of options.
+    */
+    dateToStringBatch: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('dateToStringBatch', args);
+        var data = parseBatchResponse(response);
+        logBatchResponse('dateToStringBatch', response, data);
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result.value,
+                errors: data.result.errors
+            });
+        }
+    },
+
+    /**
+    * Formats an array of numbers with one set of options.
+    */
+    numberToStringBatch: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('numberToStringBatch', args);
+        var data = parseBatchResponse(response);
+        logBatchResponse('numberToStringBatch', response, data);
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result.value,
+                errors: data.result.errors
+            });
+        }
+    },
+
+    /**
+    * Parses an array of number strings with one set of options.
+    */
+    stringToNumberBatch: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('stringToNumberBatch', args);
+        var data = parseBatchResponse(response);
+        logBatchResponse('stringToNumberBatch', response, data);
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result.value,
+                errors: data.result.errors
+            });
+        }
+    },
+
+    /**
+    * Runs a batch command in chunks. The extension returns at once and sends
+    * each chunk as an event; successCB gets one call per chunk and a last one
+    * with done set.
+    */
+    streamBatch: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var callbackId = decodeURIComponent(args.callbackId);
+        var response = g11n.getInstance().StreamBatch(callbackId, JSON.parse(decodeURIComponent(args['0'])),
+            JSON.parse(decodeURIComponent(args['1'])), decodeURIComponent(args['2']));
+        var data = JSON.parse(response);
+        logBatchResponse('streamBatch', response, data);
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            streams[callbackId] = { result: result, offset: 0 };
+            result.noResult(true);
+        }
+    },
+
+    /**
+    * Returns the capacity, size, hit/miss/eviction counters and approximate
+    * memory footprint of the per-locale formatter cache.
+    */
+    getCacheStats: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('getCacheStats', args);
+        var data = JSON.parse(response);
+        console.log('getCacheStats: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok(data.result);
+        }
+    },
+
+    /**
+    * Sets how many locales the per-locale formatter cache keeps.
+    */
+    setCacheCapacity: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('setCacheCapacity', args);
+        var data = JSON.parse(response);
+        console.log('setCacheCapacity: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
+    },
+
+    /**
+    * Sets the years covered by the precomputed daylight savings transition tables.
+    */
+    setTransitionWindow: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('setTransitionWindow', args);
+        var data = JSON.parse(response);
+        console.log('setTransitionWindow: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
+    },
+
+    /**
+    * Returns call counts, error counts and latency percentiles per command.
+    */
+    getStats: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('getStats', args);
+        var data = JSON.parse(response);
+        console.log('getStats: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok(data.result);
+        }
+    },
+
+    /**
+    * Returns the live native object and context counts of the JNEXT plugin.
+    */
+    getObjectCounts: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().ObjectCounts();
+        console.log('getObjectCounts: ' + JSON.stringify(response));
+
+        if (response.indexOf('Ok ') !== 0) {
+            result.error({
+                code: 0,
+                message: response
+            });
+        } else {
+            result.ok(JSON.parse(response.substring(3)));
+        }
+    },
+
+    /**
+    * Clears the per-command statistics.
+    */
+    resetStats: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('resetStats', args);
+        var data = JSON.parse(response);
+        console.log('resetStats: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
+    },
+    /**
+    * Clears the trace buffer and starts recording spans.
+    */
+    startTrace: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('startTrace', args);
+        var data = JSON.parse(response);
+        console.log('startTrace: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
+    },
+    /**
+    * Stops recording spans.
+    */
+    stopTrace: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('stopTrace', args);
+        var data = JSON.parse(response);
+        console.log('stopTrace: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
+    },
+    /**
+    * Writes the recorded spans to a file as Chrome trace_event JSON.
+    */
+    dumpTrace: function (successCB, failureCB, args, env) {
+        var result = new PluginResult(args, env);
+        var response = g11n.getInstance().InvokeMethod('dumpTrace', args);
+        var data = JSON.parse(response);
+        console.log('dumpTrace: ' + JSON.stringify(response));
+
+        if (data.error !== undefined) {
+            result.error({
+                code: data.error.code,
+                message: data.error.message
+            });
+        } else {
+            result.ok({
+                value: data.result
+            });
+        }
     }
 };
 
@@ -575,6 +849,87 @@ function cmdLineForMethod (method, args) {
     if (cmd.length > 0) { return method + ' ' + cmd; } else { return method; }
 }
 
+// Batch results in the compact encoding: base64 of little-endian
+// binary, laid out as described in src/common/compact_encoding.hpp.
+// Errors of the whole command are JSON either way.
+var BASE64_ALPHABET = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+var base64Values = {};
+
+for (var i = 0; i < BASE64_ALPHABET.length; i++) {
+    base64Values[BASE64_ALPHABET.charAt(i)] = i;
+}
+
+function decodeBase64 (text) {
+    var padding = text.charAt(text.length - 1) === '=' ? (text.charAt(text.length - 2) === '=' ? 2 : 1) : 0;
+    var bytes = new Uint8Array(text.length / 4 * 3 - padding);
+    var length = 0;
+
+    for (var i = 0; i < text.length; i += 4) {
+        var group = base64Values[text.charAt(i)] << 18 | base64Values[text.charAt(i + 1)] << 12 |
+            (base64Values[text.charAt(i + 2)] || 0) << 6 | (base64Values[text.charAt(i + 3)] || 0);
+        bytes[length++] = group >> 16;
+        if (length < bytes.length) { bytes[length++] = group >> 8 & 255; }
+        if (length < bytes.length) { bytes[length++] = group & 255; }
+    }
+
+    return bytes;
+}
+
+function decodeCompactBatch (text) {
+    var bytes = decodeBase64(text);
+    var view = new DataView(bytes.buffer);
+    var offset = 0;
+
+    function readString () {
+        var length = view.getUint32(offset, true);
+        var binary = '';
+        offset += 4;
+        for (var end = offset + length; offset < end; offset++) {
+            binary += String.fromCharCode(bytes[offset]);
+        }
+        return decodeURIComponent(escape(binary));
+    }
+
+    var count = view.getUint32(offset, true);
+    var values = [];
+    var errors = [];
+    offset += 4;
+
+    for (var i = 0; i < count; i++) {
+        var tag = bytes[offset++];
+        if (tag === 1) {
+            values.push(view.getFloat64(offset, true));
+            offset += 8;
+        } else if (tag === 2) {
+            values.push(readString());
+        } else {
+            values.push(null);
+        }
+    }
+
+    var errorCount = view.getUint32(offset, true);
+    offset += 4;
+
+    for (i = 0; i < errorCount; i++) {
+        var index = view.getUint32(offset, true);
+        var code = bytes[offset + 4];
+        offset += 5;
+        errors.push({ index: index, code: code, message: readString() });
+    }
+
+    return { result: { value: values, errors: errors } };
+}
+
+function parseBatchResponse (response) {
+    return response.charAt(0) === '{' ? JSON.parse(response) : decodeCompactBatch(response);
+}
+
+// Batch results can be large, so only their size and any error are logged.
+function logBatchResponse (method, response, data) {
+    console.log(method + ': ' + response.length + ' characters' +
+        (data.error !== undefined ? ', error: ' + JSON.stringify(data.error) : ''));
+}
+
 /// ////////////////////////////////////////////////////////////////
 // JavaScript wrapper for JNEXT plugin
 /// ////////////////////////////////////////////////////////////////
@@ -585,7 +940,59 @@ JNEXT.Globalization = function () {
 
     self.InvokeMethod = function (method, args) {
         // This is how Javascript calls into native
-        return JNEXT.invoke(self.m_id, cmdLineForMethod(method, args));
+        return JNEXT.invoke(self.m_id, self.m_handle + cmdLineForMethod(method, args));
+    };
+
+    // Answered by the plugin itself rather than the Globalization object.
+    self.ObjectCounts = function () {
+        return JNEXT.invoke(self.m_id, self.m_handle + '@Counts');
+    };
+
+    self.StreamBatch = function (callbackId, command, chunkSize, json) {
+        return JNEXT.invoke(self.m_id, self.m_handle + 'streamBatch ' + callbackId + ' ' + command + ' ' + chunkSize + ' ' + json);
+    };
+
+    // Events are "<callbackId> chunk <result>" and "<callbackId> done <summary>".
+    self.onEvent = function (strData) {
+        var kindIndex = strData.indexOf(' ');
+        var payloadIndex = strData.indexOf(' ', kindIndex + 1);
+        var callbackId = strData.substring(0, kindIndex);
+        var kind = strData.substring(kindIndex + 1, payloadIndex);
+        var payload = strData.substring(payloadIndex + 1);
+        var stream = streams[callbackId];
+        var data;
+
+        if (stream === undefined) {
+            return;
+        }
+
+        if (kind === 'chunk') {
+            data = parseBatchResponse(payload);
+            stream.result.callbackOk({
+                value: data.result.value,
+                errors: data.result.errors,
+                offset: stream.offset,
+                done: false
+            }, true);
+            stream.offset += data.result.value.length;
+            return;
+        }
+
+        delete streams[callbackId];
+        data = JSON.parse(payload);
+        if (data.error !== undefined) {
+            stream.result.callbackError({
+                code: data.error.code,
+                message: data.error.message
+            }, false);
+        } else {
+            stream.result.callbackOk({
+                value: [],
+                errors: [],
+                offset: data.result.count,
+                done: true
+            }, false);
+        }
     };
 
     self.init = function () {
@@ -601,11 +1008,27 @@ JNEXT.Globalization = function () {
             return false;
         }
 
+        // Later calls also name the object's integer handle, which the
+        // plugin resolves without looking the id up.
+        var reply = JNEXT.invoke(self.m_id, '@Handle');
+        if (reply.indexOf('Ok ') === 0) {
+            self.m_handle = '#' + reply.substring(3) + ' ';
+        }
+
+        // Batch results are asked for in the compact encoding; an extension
+        // without it answers with an unknown command and keeps to JSON.
+        // parseBatchResponse tells the two apart by their first character.
+        self.InvokeMethod('setResultEncoding', {
+            callbackId: '0',
+            '0': encodeURIComponent(JSON.stringify({ encoding: 'compact' }))
+        });
+
         // Registers for the JNEXT event loop
         JNEXT.registerEvents(self);
     };
 
     self.m_id = '';
+    self.m_handle = '';
 
     // Used by JNEXT library to get the ID
     self.getId = function () {
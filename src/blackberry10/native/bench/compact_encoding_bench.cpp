@@ -0,0 +1,199 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Encode and decode cost of batch results as JSON and in the compact
+ * encoding, for number results (stringToNumberBatch) and string results
+ * (numberToStringBatch, dateToStringBatch). Decoding checks that both
+ * encodings give back the values that went in, and reports whether the
+ * numbers came back bit for bit.
+ *
+ * usage: compact_encoding_bench [-n elements] [-r rounds]
+ *
+ * Built by the host CMake build.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include "compact_encoding.hpp"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct Values {
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+};
+
+static std::string encodeJson(const Values& values)
+{
+    Json::Value array(Json::arrayValue);
+    for (size_t i = 0; i < values.numbers.size(); ++i)
+        array.append(values.numbers[i]);
+    for (size_t i = 0; i < values.strings.size(); ++i)
+        array.append(values.strings[i]);
+
+    Json::Value root;
+    root["result"]["value"] = array;
+    root["result"]["errors"] = Json::Value(Json::arrayValue);
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+static std::string encodeCompact(const Values& values)
+{
+    CompactWriter writer;
+    writer.putUInt32((unsigned) (values.numbers.size() + values.strings.size()));
+    for (size_t i = 0; i < values.numbers.size(); ++i) {
+        writer.putByte(kCompactNumber);
+        writer.putDouble(values.numbers[i]);
+    }
+    for (size_t i = 0; i < values.strings.size(); ++i) {
+        writer.putByte(kCompactString);
+        writer.putString(values.strings[i]);
+    }
+    writer.putUInt32(0);
+    return base64Encode(writer.bytes());
+}
+
+static bool decodeJson(const std::string& text, Values& values)
+{
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(text, root))
+        return false;
+
+    const Json::Value& array = root["result"]["value"];
+    for (Json::Value::UInt i = 0; i < array.size(); ++i) {
+        if (array[i].isString())
+            values.strings.push_back(array[i].asString());
+        else
+            values.numbers.push_back(array[i].asDouble());
+    }
+    return true;
+}
+
+static bool decodeCompact(const std::string& text, Values& values)
+{
+    std::string bytes;
+    if (!base64Decode(text, bytes))
+        return false;
+
+    CompactReader reader(bytes);
+    unsigned count;
+    if (!reader.getUInt32(count))
+        return false;
+
+    std::string value;
+    double number;
+    for (unsigned i = 0; i < count; ++i) {
+        unsigned char tag;
+        if (!reader.getByte(tag))
+            return false;
+        if (tag == kCompactNumber) {
+            if (!reader.getDouble(number))
+                return false;
+            values.numbers.push_back(number);
+        } else if (tag == kCompactString) {
+            if (!reader.getString(value))
+                return false;
+            values.strings.push_back(value);
+        }
+    }
+
+    unsigned errors;
+    return reader.getUInt32(errors) && errors == 0 && reader.atEnd();
+}
+
+static void run(const char* name, const Values& values, int rounds)
+{
+    typedef std::string (*Encoder)(const Values&);
+    typedef bool (*Decoder)(const std::string&, Values&);
+    static const Encoder encoders[] = { encodeJson, encodeCompact };
+    static const Decoder decoders[] = { decodeJson, decodeCompact };
+    static const char* encodings[] = { "json", "compact" };
+
+    size_t count = values.numbers.size() + values.strings.size();
+    for (int e = 0; e < 2; ++e) {
+        std::string text;
+        double start = now();
+        for (int r = 0; r < rounds; ++r)
+            text = encoders[e](values);
+        double encodeTime = (now() - start) / rounds;
+
+        Values decoded;
+        start = now();
+        for (int r = 0; r < rounds; ++r) {
+            decoded = Values();
+            if (!decoders[e](text, decoded)) {
+                fprintf(stderr, "%s %s: decoding failed\n", name, encodings[e]);
+                exit(1);
+            }
+        }
+        double decodeTime = (now() - start) / rounds;
+
+        // jsoncpp writes doubles with 16 significant digits, so JSON does
+        // not always give back the same number.
+        bool exact = decoded.numbers == values.numbers && decoded.strings == values.strings;
+        if (decoded.numbers.size() != values.numbers.size() || decoded.strings != values.strings) {
+            fprintf(stderr, "%s %s: decoded values differ\n", name, encodings[e]);
+            exit(1);
+        }
+
+        printf("%-8s %-8s %10u %12.1f %12.1f %8.2f %6s\n", name, encodings[e], (unsigned) text.size(),
+                encodeTime * 1e9 / count, decodeTime * 1e9 / count, (double) text.size() / count,
+                exact ? "yes" : "no");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int count = 10000;
+    int rounds = 20;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            count = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            rounds = atoi(argv[++i]);
+    }
+
+    srand(42);
+    Values numbers, strings;
+    char buffer[32];
+    for (int i = 0; i < count; ++i) {
+        double value = (double) rand() / RAND_MAX * 1e6;
+        numbers.numbers.push_back(value);
+        snprintf(buffer, sizeof(buffer), "%.3f", value);
+        strings.strings.push_back(buffer);
+    }
+
+    printf("%-8s %-8s %10s %12s %12s %8s %6s\n", "values", "encoding", "bytes", "encode ns", "decode ns",
+            "bytes/el", "exact");
+    run("numbers", numbers, rounds);
+    run("strings", strings, rounds);
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark for the compiled stringToDate parser.
+ *
+ * Parses a corpus of date strings (one per line, 100k generated lines by
+ * default) three ways: a new ICU DateFormat per string as stringToDate used
+ * to do, a single cached ICU DateFormat, and CompiledDateParser. Results of
+ * the compiled parser are checked against ICU for every line.
+ *
+ * usage: date_parser_bench [-l locale] [-s short|medium|long|full] [corpus]
+ *
+ * Built on a Linux host against the system ICU:
+ *   g++ -O2 -DU_USING_ICU_NAMESPACE=1 -I../../../common date_parser_bench.cpp ../../../common/date_parser.cpp \
+ *       -licui18n -licuuc -o date_parser_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unicode/calendar.h>
+#include <unicode/datefmt.h>
+#include "date_parser.hpp"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool sameFields(const DateFields& a, const DateFields& b)
+{
+    return a.year == b.year && a.month == b.month && a.day == b.day
+        && a.hour == b.hour && a.minute == b.minute && a.second == b.second
+        && a.millisecond == b.millisecond;
+}
+
+static bool parseWithICU(DateFormat* df, Calendar* cal, const std::string& line, DateFields& fields)
+{
+    UnicodeString text = UnicodeString::fromUTF8(line);
+    UErrorCode status = U_ZERO_ERROR;
+    UDate date = df->parse(text, status);
+    if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START)
+        return false;
+
+    cal->setTime(date, status);
+    fields.year = cal->get(UCAL_YEAR, status);
+    fields.month = cal->get(UCAL_MONTH, status);
+    fields.day = cal->get(UCAL_DAY_OF_MONTH, status);
+    fields.hour = cal->get(UCAL_HOUR, status);
+    fields.minute = cal->get(UCAL_MINUTE, status);
+    fields.second = cal->get(UCAL_SECOND, status);
+    fields.millisecond = cal->get(UCAL_MILLISECOND, status);
+    return true;
+}
+
+// What stringToDate did before parsers were cached.
+static bool parseUncached(DateFormat::EStyle style, const std::string& line, DateFields& fields)
+{
+    DateFormat* df = DateFormat::createDateTimeInstance(style, style, Locale::getDefault());
+    UErrorCode status = U_ZERO_ERROR;
+    Calendar* cal = Calendar::createInstance(status);
+    bool ok = df && cal && parseWithICU(df, cal, line, fields);
+    delete cal;
+    delete df;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    DateFormat::EStyle style = DateFormat::kShort;
+    const char* corpus = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            UErrorCode status = U_ZERO_ERROR;
+            Locale::setDefault(Locale::createFromName(argv[++i]), status);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            std::string s = argv[++i];
+            if (s == "full")
+                style = DateFormat::kFull;
+            else if (s == "long")
+                style = DateFormat::kLong;
+            else if (s == "medium")
+                style = DateFormat::kMedium;
+        } else {
+            corpus = argv[i];
+        }
+    }
+
+    std::vector<std::string> lines;
+    DateFormat* df = DateFormat::createDateTimeInstance(style, style, Locale::getDefault());
+    if (!df) {
+        fprintf(stderr, "Unable to create DateFormat instance!\n");
+        return 1;
+    }
+
+    if (corpus) {
+        std::ifstream in(corpus);
+        std::string line;
+        while (std::getline(in, line))
+            lines.push_back(line);
+    } else {
+        // 100k dates spread over 1990..2030, all in the locale's pattern.
+        srand(42);
+        for (int i = 0; i < 100000; ++i) {
+            UDate date = 631152000000.0 + (double) rand() / RAND_MAX * 1262304000000.0;
+            UnicodeString text;
+            df->format(date, text);
+            std::string utf8;
+            text.toUTF8String(utf8);
+            lines.push_back(utf8);
+        }
+    }
+
+    CompiledDateParser compiled(DateFormat::createDateTimeInstance(style, style, Locale::getDefault()));
+    UErrorCode status = U_ZERO_ERROR;
+    Calendar* cal = Calendar::createInstance(status);
+    if (!cal) {
+        fprintf(stderr, "Unable to create Calendar instance!\n");
+        return 1;
+    }
+
+    printf("locale: %s, lines: %u, compiled: %s\n", Locale::getDefault().getName(),
+            (unsigned) lines.size(), compiled.isCompiled() ? "yes" : "no");
+
+    // The per call path is slow, a tenth of the corpus is enough.
+    size_t uncachedLines = lines.size() / 10 + 1;
+    if (uncachedLines > lines.size())
+        uncachedLines = lines.size();
+    DateFields fields;
+    double start = now();
+    for (size_t i = 0; i < uncachedLines; ++i)
+        parseUncached(style, lines[i], fields);
+    double uncached = now() - start;
+
+    // ICU lenient parser on a cached DateFormat, this is also the reference.
+    std::vector<DateFields> expected(lines.size());
+    std::vector<bool> expectedOk(lines.size());
+    start = now();
+    for (size_t i = 0; i < lines.size(); ++i)
+        expectedOk[i] = parseWithICU(df, cal, lines[i], expected[i]);
+    double cached = now() - start;
+
+    size_t matched = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (compiled.match(lines[i], fields))
+            ++matched;
+    }
+
+    // Compiled matcher with ICU fallback.
+    std::vector<DateFields> actual(lines.size());
+    std::vector<bool> actualOk(lines.size());
+    start = now();
+    for (size_t i = 0; i < lines.size(); ++i)
+        actualOk[i] = compiled.parse(lines[i], actual[i]);
+    double fast = now() - start;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (actualOk[i] != expectedOk[i] || (actualOk[i] && !sameFields(actual[i], expected[i]))) {
+            if (mismatches < 10)
+                fprintf(stderr, "mismatch: '%s'\n", lines[i].c_str());
+            ++mismatches;
+        }
+    }
+
+    printf("%-28s %10.1f ns/line\n", "ICU, DateFormat per call", uncached * 1e9 / uncachedLines);
+    printf("%-28s %10.1f ns/line\n", "ICU, cached DateFormat", cached * 1e9 / lines.size());
+    printf("%-28s %10.1f ns/line\n", "CompiledDateParser", fast * 1e9 / lines.size());
+    printf("compiled matches: %u/%u, mismatches against ICU: %u\n",
+            (unsigned) matched, (unsigned) lines.size(), (unsigned) mismatches);
+
+    delete cal;
+    delete df;
+    return mismatches ? 1 : 0;
+}
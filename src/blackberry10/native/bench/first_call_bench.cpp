@@ -0,0 +1,165 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Time-to-first-call with and without prewarming.
+ *
+ * Every sample runs in a freshly forked process so that ICU starts with no
+ * data loaded. The child creates a GlobalizationEngine, sleeps for the given
+ * delay to stand in for the application's own startup work, and times the
+ * first dateToString, numberToString and getDateNames call. The median,
+ * minimum and maximum over all runs are reported for both modes.
+ *
+ * usage: first_call_bench [-d delay_ms] [-l locale] [-r runs]
+ *
+ * Built by the host CMake build:
+ *   build/first_call_bench -d 200 -r 20
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <unicode/locid.h>
+#include "globalization_engine.hpp"
+
+using namespace webworks;
+
+enum ECommand {
+    kDateToString,
+    kNumberToString,
+    kGetDateNames,
+    kCommandCount
+};
+
+static const char* kCommandNames[kCommandCount] = { "dateToString", "numberToString", "getDateNames" };
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::string invoke(GlobalizationEngine& engine, int command)
+{
+    switch (command) {
+    case kDateToString:
+    default:
+        return engine.dateToString("{\"date\":1388577600000}");
+    case kNumberToString:
+        return engine.numberToString("{\"number\":1234.5678}");
+    case kGetDateNames:
+        return engine.getDateNames("{\"options\":{\"type\":\"wide\",\"item\":\"months\"}}");
+    }
+}
+
+// Returns the first call latency in seconds measured in a new process, or
+// a negative value if the child failed.
+static double sample(int command, bool prewarm, int delayMs, const char* locale)
+{
+    int fds[2];
+    if (pipe(fds))
+        return -1;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (!pid) {
+        close(fds[0]);
+        if (locale) {
+            UErrorCode status = U_ZERO_ERROR;
+            Locale::setDefault(Locale::createFromName(locale), status);
+        }
+
+        GlobalizationEngine engine(prewarm);
+        if (delayMs)
+            usleep(delayMs * 1000);
+
+        double start = now();
+        std::string result = invoke(engine, command);
+        double elapsed = now() - start;
+
+        if (result.find("\"result\"") == std::string::npos)
+            elapsed = -1;
+        ssize_t written = write(fds[1], &elapsed, sizeof(elapsed));
+        _exit(written == sizeof(elapsed) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    double elapsed = -1;
+    if (read(fds[0], &elapsed, sizeof(elapsed)) != sizeof(elapsed))
+        elapsed = -1;
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    int delayMs = 50;
+    int runs = 15;
+    const char* locale = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            delayMs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            locale = argv[++i];
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        }
+    }
+
+    if (runs <= 0)
+        runs = 1;
+
+    printf("locale: %s, delay: %d ms, runs: %d\n", locale ? locale : "default", delayMs, runs);
+    printf("%-16s %-8s %12s %12s %12s\n", "command", "prewarm", "median us", "min us", "max us");
+
+    int failures = 0;
+    for (int command = 0; command < kCommandCount; ++command) {
+        for (int prewarm = 0; prewarm < 2; ++prewarm) {
+            std::vector<double> samples;
+            for (int i = 0; i < runs; ++i) {
+                double elapsed = sample(command, prewarm, delayMs, locale);
+                if (elapsed < 0)
+                    ++failures;
+                else
+                    samples.push_back(elapsed);
+            }
+
+            if (samples.empty())
+                continue;
+
+            std::sort(samples.begin(), samples.end());
+            printf("%-16s %-8s %12.1f %12.1f %12.1f\n", kCommandNames[command], prewarm ? "on" : "off",
+                    samples[samples.size() / 2] * 1e6, samples.front() * 1e6, samples.back() * 1e6);
+        }
+    }
+
+    if (failures)
+        fprintf(stderr, "%d samples failed\n", failures);
+
+    return failures ? 1 : 0;
+}
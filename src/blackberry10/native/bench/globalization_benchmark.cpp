@@ -0,0 +1,192 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Google Benchmark suite over every command GlobalizationJS::InvokeMethod
+ * dispatches, driven through the JNEXT entry point InvokeFunction the way
+ * the JavaScript side calls it. Besides ns/op every benchmark reports
+ * allocs/op, counted by wrapping malloc for the whole process so that
+ * allocations made inside ICU are included.
+ *
+ * Built by the host CMake build when Google Benchmark is installed:
+ *   build/globalization_benchmark [--benchmark_filter=dateToString]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "command_stats.hpp"
+#include "plugin.h"
+
+struct Command {
+    const char* name;
+    const char* method;
+    const char* args;
+};
+
+static const Command kCommands[] = {
+    { "getPreferredLanguage", "getPreferredLanguage", "" },
+    { "getLocaleName", "getLocaleName", "" },
+    { "dateToString/short", "dateToString", "{\"date\":1388577600000}" },
+    { "dateToString/full", "dateToString",
+        "{\"date\":1388577600000,\"options\":{\"formatLength\":\"full\"}}" },
+    { "dateToString/locale+timeZone", "dateToString",
+        "{\"date\":1388577600000,\"options\":{\"locale\":\"de-DE\",\"timeZone\":\"Europe/Berlin\"}}" },
+    { "stringToDate/short", "stringToDate", "{\"dateString\":\"1/1/14, 12:00 PM\"}" },
+    { "stringToDate/medium", "stringToDate",
+        "{\"dateString\":\"Jan 1, 2014, 12:00:00 PM\",\"options\":{\"formatLength\":\"medium\"}}" },
+    { "getDatePattern", "getDatePattern", "{\"options\":{\"formatLength\":\"long\"}}" },
+    { "getDateNames/months", "getDateNames", "{\"options\":{\"type\":\"wide\",\"item\":\"months\"}}" },
+    { "getDateNames/days", "getDateNames", "{\"options\":{\"type\":\"narrow\",\"item\":\"days\"}}" },
+    { "isDayLightSavingsTime", "isDayLightSavingsTime", "{\"date\":1404216000000}" },
+    { "isDayLightSavingsTime/timeZone", "isDayLightSavingsTime",
+        "{\"date\":1404216000000,\"options\":{\"timeZone\":\"America/New_York\"}}" },
+    { "getFirstDayOfWeek", "getFirstDayOfWeek", "{}" },
+    { "numberToString/decimal", "numberToString", "{\"number\":1234567.891}" },
+    { "numberToString/percent", "numberToString",
+        "{\"number\":0.4567,\"options\":{\"type\":\"percent\"}}" },
+    { "numberToString/currency", "numberToString",
+        "{\"number\":1234.5,\"options\":{\"type\":\"currency\"}}" },
+    { "stringToNumber/decimal", "stringToNumber", "{\"numberString\":\"1,234,567.891\"}" },
+    { "stringToNumber/currency", "stringToNumber",
+        "{\"numberString\":\"$1,234.50\",\"options\":{\"type\":\"currency\",\"locale\":\"en-US\"}}" },
+    { "getNumberPattern", "getNumberPattern", "{\"options\":{\"type\":\"decimal\"}}" },
+    { "getCurrencyPattern", "getCurrencyPattern", "{\"currencyCode\":\"EUR\"}" },
+    { "getCurrencyPattern/locale", "getCurrencyPattern",
+        "{\"currencyCode\":\"EUR\",\"options\":{\"locale\":\"fr-FR\"}}" },
+    { "getCacheStats", "getCacheStats", "" },
+    { "setCacheCapacity", "setCacheCapacity", "{\"capacity\":4}" },
+    { "setTransitionWindow", "setTransitionWindow", "{\"firstYear\":1970,\"lastYear\":2037}" },
+    { "getStats", "getStats", "" },
+    // Ten elements each, to compare with ten of the single value calls above.
+    { "dateToStringBatch/10", "dateToStringBatch",
+        "{\"dates\":[1388577600000,1388664000000,1388750400000,1388836800000,1388923200000,"
+        "1389009600000,1389096000000,1389182400000,1389268800000,1389355200000]}" },
+    { "numberToStringBatch/10", "numberToStringBatch",
+        "{\"numbers\":[1234567.891,0.5,42,-17.25,1e6,3.14159,99.99,123456,0.001,7]}" },
+    { "stringToNumberBatch/10", "stringToNumberBatch",
+        "{\"numberStrings\":[\"1,234,567.891\",\"0.5\",\"42\",\"-17.25\",\"1,000,000\","
+        "\"3.14159\",\"99.99\",\"123,456\",\"0.001\",\"7\"]}" }
+};
+
+static int g_context;
+
+static void onEvent(const char*, void*)
+{
+}
+
+static void invoke(benchmark::State& state, const Command* command)
+{
+    // "InvokeMethod <object id> <method> <callback id> <json>" as index.js builds it.
+    std::string line = std::string(szINVOKE) + " 1 " + command->method + " 7";
+    if (*command->args)
+        line.append(" ").append(command->args);
+
+    std::string result = InvokeFunction(line.c_str(), &g_context);
+    if (result.find("\"error\"") != std::string::npos || result.compare(0, strlen(szERROR), szERROR) == 0) {
+        state.SkipWithError(result.c_str());
+        return;
+    }
+
+    unsigned long allocations = 0;
+    while (state.KeepRunning()) {
+        unsigned long before = allocationCount();
+        benchmark::DoNotOptimize(InvokeFunction(line.c_str(), &g_context));
+        allocations += allocationCount() - before;
+    }
+
+    state.counters["allocs/op"] = benchmark::Counter((double) allocations, benchmark::Counter::kAvgIterations);
+}
+
+// The JNEXT layer alone: an unknown method with a 4 KB payload, addressed
+// by object id or by the integer handle the @Handle method returns.
+static void dispatch(benchmark::State& state, bool byHandle)
+{
+    std::string target = "1";
+    if (byHandle) {
+        std::string reply = InvokeFunction((std::string(szINVOKE) + " 1 " + szHANDLE).c_str(), &g_context);
+        target.append(" #").append(reply.substr(strlen(szOK)));
+    }
+
+    std::string line = std::string(szINVOKE) + " " + target + " noop 7 {\"values\":[";
+    for (int i = 0; i < 512; ++i)
+        line.append(i ? ",1234567" : "1234567");
+    line.append("]}");
+
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(InvokeFunction(line.c_str(), &g_context));
+}
+
+// A browser context that creates an object, makes one call and goes away.
+// The live counts reported afterwards stay at the one long lived object.
+static void contextChurn(benchmark::State& state)
+{
+    static int contexts[16];
+    std::string create = std::string(szCREATE) + " Globalization 2";
+    std::string call = std::string(szINVOKE) + " 2 getLocaleName 7";
+    std::string destroy = std::string(szINVOKE) + " 2 " + szDESTROYCONTEXT;
+    size_t next = 0;
+
+    while (state.KeepRunning()) {
+        void* context = &contexts[next++ % 16];
+        InvokeFunction(create.c_str(), context);
+        benchmark::DoNotOptimize(InvokeFunction(call.c_str(), context));
+        InvokeFunction(destroy.c_str(), context);
+    }
+
+    unsigned int objects, live, pooled;
+    g_getObjectCounts(objects, live, pooled);
+    state.counters["objects"] = objects;
+    state.counters["contexts"] = live;
+    state.counters["pooled"] = pooled;
+}
+
+// What InvokeMethod adds to every command while statistics are compiled in.
+static void recordStats(benchmark::State& state)
+{
+    static webworks::CommandStats stats;
+
+    while (state.KeepRunning()) {
+        unsigned long long start = webworks::TickClock::now();
+        stats.record(webworks::kDateToString, webworks::TickClock::now() - start, false);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SetEventFunc(onEvent);
+    std::string created = InvokeFunction((std::string(szCREATE) + " Globalization 1").c_str(), &g_context);
+    if (created.compare(0, strlen(szOK), szOK) != 0) {
+        fprintf(stderr, "%s\n", created.c_str());
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(kCommands) / sizeof(kCommands[0]); ++i)
+        benchmark::RegisterBenchmark(kCommands[i].name, invoke, &kCommands[i]);
+    benchmark::RegisterBenchmark("InvokeFunction/id", dispatch, false);
+    benchmark::RegisterBenchmark("InvokeFunction/handle", dispatch, true);
+    benchmark::RegisterBenchmark("Context/churn", contextChurn);
+    benchmark::RegisterBenchmark("CommandStats/record", recordStats);
+    benchmark::RegisterBenchmark("CommandStats/record/threads", recordStats)->Threads(4);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
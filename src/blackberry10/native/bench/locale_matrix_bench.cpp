@@ -0,0 +1,236 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Per-locale cost of every locale dependent GlobalizationEngine operation.
+ *
+ * For each locale from Locale::getAvailableLocales() (or the -l list) every
+ * operation is called once cold, with nothing cached for the locale, and
+ * then -n times warm. The CSV on stdout has one row per locale and
+ * operation with the cold latency, the median warm latency, allocations per
+ * warm call and whether the call failed. A warm latency more than three
+ * times the median of the same operation over all locales is flagged as
+ * an outlier in the CSV and listed on stderr.
+ *
+ * usage: locale_matrix_bench [-n iterations] [-l locale,locale,...]
+ *
+ * Built by the host CMake build:
+ *   build/locale_matrix_bench -l en_US,ja_JP,ar_EG,hi_IN > matrix.csv
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <unicode/locid.h>
+#include "alloc_counter.hpp"
+#include "globalization_engine.hpp"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef std::string (GlobalizationEngine::*Method)(const std::string& args);
+
+struct Operation {
+    const char* name;
+    Method method;
+    const char* args;
+};
+
+// Arguments are JSON with $LOCALE standing for the locale; stringToDate and
+// stringToNumber parse what dateToString and numberToString produced.
+static const Operation kOperations[] = {
+    { "dateToString", &GlobalizationEngine::dateToString,
+        "{\"date\":1388577600000,\"options\":{\"locale\":$LOCALE}}" },
+    { "dateToString/full", &GlobalizationEngine::dateToString,
+        "{\"date\":1388577600000,\"options\":{\"locale\":$LOCALE,\"formatLength\":\"full\"}}" },
+    { "stringToDate", &GlobalizationEngine::stringToDate,
+        "{\"dateString\":$DATE,\"options\":{\"locale\":$LOCALE}}" },
+    { "getDatePattern", &GlobalizationEngine::getDatePattern, "{\"options\":{\"locale\":$LOCALE}}" },
+    { "getDateNames", &GlobalizationEngine::getDateNames,
+        "{\"options\":{\"locale\":$LOCALE,\"type\":\"wide\",\"item\":\"months\"}}" },
+    { "getFirstDayOfWeek", &GlobalizationEngine::getFirstDayOfWeek, "{\"options\":{\"locale\":$LOCALE}}" },
+    { "numberToString", &GlobalizationEngine::numberToString,
+        "{\"number\":1234567.891,\"options\":{\"locale\":$LOCALE,\"type\":\"decimal\"}}" },
+    { "numberToString/percent", &GlobalizationEngine::numberToString,
+        "{\"number\":0.4567,\"options\":{\"locale\":$LOCALE,\"type\":\"percent\"}}" },
+    { "numberToString/currency", &GlobalizationEngine::numberToString,
+        "{\"number\":1234.5,\"options\":{\"locale\":$LOCALE,\"type\":\"currency\"}}" },
+    { "stringToNumber", &GlobalizationEngine::stringToNumber,
+        "{\"numberString\":$NUMBER,\"options\":{\"locale\":$LOCALE,\"type\":\"decimal\"}}" },
+    { "getNumberPattern", &GlobalizationEngine::getNumberPattern,
+        "{\"options\":{\"locale\":$LOCALE,\"type\":\"decimal\"}}" },
+    { "getCurrencyPattern", &GlobalizationEngine::getCurrencyPattern,
+        "{\"currencyCode\":\"EUR\",\"options\":{\"locale\":$LOCALE}}" }
+};
+
+static const int kOperationCount = sizeof(kOperations) / sizeof(kOperations[0]);
+
+struct Sample {
+    std::string locale;
+    int operation;
+    double cold;
+    double warm;
+    double allocations;
+    bool error;
+};
+
+static std::string quote(const std::string& value)
+{
+    Json::FastWriter writer;
+    std::string json = writer.write(Json::Value(value));
+    return json.substr(0, json.size() - 1);
+}
+
+static void substitute(std::string& args, const char* name, const std::string& value)
+{
+    size_t pos = args.find(name);
+    if (pos != std::string::npos)
+        args.replace(pos, strlen(name), value);
+}
+
+// The "result" string of a successful call, empty otherwise.
+static std::string resultString(const std::string& json)
+{
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(json, root) || !root["result"].isString())
+        return std::string();
+    return root["result"].asString();
+}
+
+static void runLocale(GlobalizationEngine& engine, const std::string& locale, int iterations, std::vector<Sample>& samples)
+{
+    std::string date, number;
+
+    for (int op = 0; op < kOperationCount; ++op) {
+        std::string args = kOperations[op].args;
+        substitute(args, "$LOCALE", quote(locale));
+        substitute(args, "$DATE", quote(date));
+        substitute(args, "$NUMBER", quote(number));
+
+        Method method = kOperations[op].method;
+        double start = now();
+        std::string result = (engine.*method)(args);
+        double cold = now() - start;
+
+        if (op == 0)
+            date = resultString(result);
+        else if (method == &GlobalizationEngine::numberToString && number.empty())
+            number = resultString(result);
+
+        // The median of single calls, so that a stray context switch on a
+        // busy host does not turn a locale into an outlier.
+        std::vector<double> times(iterations);
+        unsigned long allocations = allocationCount();
+        for (int i = 0; i < iterations; ++i) {
+            start = now();
+            (engine.*method)(args);
+            times[i] = now() - start;
+        }
+        allocations = allocationCount() - allocations;
+        std::nth_element(times.begin(), times.begin() + iterations / 2, times.end());
+        double warm = times[iterations / 2];
+
+        Sample sample;
+        sample.locale = locale;
+        sample.operation = op;
+        sample.cold = cold;
+        sample.warm = warm;
+        sample.allocations = (double) allocations / iterations;
+        sample.error = result.compare(0, 9, "{\"error\":") == 0;
+        samples.push_back(sample);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 200;
+    std::vector<std::string> locales;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos)
+                    end = list.size();
+                if (end > start)
+                    locales.push_back(list.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+    }
+
+    if (locales.empty()) {
+        int32_t count = 0;
+        const Locale* available = Locale::getAvailableLocales(count);
+        for (int32_t i = 0; i < count; ++i)
+            locales.push_back(available[i].getName());
+    }
+
+    if (iterations < 1) {
+        fprintf(stderr, "usage: locale_matrix_bench [-n iterations] [-l locale,locale,...]\n");
+        return 2;
+    }
+
+    GlobalizationEngine engine;
+    std::vector<Sample> samples;
+    for (size_t i = 0; i < locales.size(); ++i)
+        runLocale(engine, locales[i], iterations, samples);
+
+    std::vector<double> medians(kOperationCount);
+    for (int op = 0; op < kOperationCount; ++op) {
+        std::vector<double> warm;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            if (samples[i].operation == op && !samples[i].error)
+                warm.push_back(samples[i].warm);
+        }
+        if (warm.empty())
+            continue;
+        std::nth_element(warm.begin(), warm.begin() + warm.size() / 2, warm.end());
+        medians[op] = warm[warm.size() / 2];
+    }
+
+    int outliers = 0;
+    printf("locale,operation,cold_us,warm_ns,allocs_per_call,error,outlier\n");
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const Sample& sample = samples[i];
+        bool outlier = medians[sample.operation] > 0 && sample.warm > 3 * medians[sample.operation];
+        printf("%s,%s,%.1f,%.0f,%.1f,%d,%d\n", sample.locale.c_str(), kOperations[sample.operation].name,
+                sample.cold * 1e6, sample.warm * 1e9, sample.allocations, sample.error, outlier);
+        if (outlier) {
+            fprintf(stderr, "outlier: %s %s %.0f ns, median %.0f ns\n", sample.locale.c_str(),
+                    kOperations[sample.operation].name, sample.warm * 1e9, medians[sample.operation] * 1e9);
+            ++outliers;
+        }
+    }
+
+    fprintf(stderr, "%u locales, %d outliers\n", (unsigned) locales.size(), outliers);
+    return 0;
+}
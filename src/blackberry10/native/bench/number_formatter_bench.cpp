@@ -0,0 +1,173 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Differential check and benchmark for the numberToString formatter.
+ *
+ * For every locale (all ICU locales with -a, the default locale otherwise)
+ * random values, rounding ties, negatives and tiny values are formatted as
+ * decimal and percent by NumberFormatter and by ICU, and the outputs are
+ * compared byte for byte. Timings of both paths are reported per locale.
+ *
+ * usage: number_formatter_bench [-a] [-l locale] [-n values]
+ *
+ * Built on a Linux host against the system ICU:
+ *   g++ -O2 -DU_USING_ICU_NAMESPACE=1 -I../../../common number_formatter_bench.cpp ../../../common/number_formatter.cpp \
+ *       -licui18n -licuuc -o number_formatter_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unicode/numfmt.h>
+#include "number_formatter.hpp"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void makeValues(int count, std::vector<double>& values)
+{
+    static const double magnitudes[] = { 1e-4, 1e-2, 1, 10, 100, 1e3, 1e4, 1e5, 1e6, 1e7, 1e9, 1e12 };
+
+    srand(42);
+    values.clear();
+    for (int i = 0; i < count; ++i) {
+        double value;
+        switch (i % 4) {
+        case 0:
+            // Rounding ties at every fraction length.
+            value = (rand() % 100000 + 0.5) / (double) (1 << (rand() % 4)) / 1000;
+            break;
+        case 1:
+            value = rand() % 10000000;
+            break;
+        default:
+            value = (double) rand() / RAND_MAX * magnitudes[rand() % 12];
+            break;
+        }
+        if (rand() % 3 == 0)
+            value = -value;
+        values.push_back(value);
+    }
+}
+
+static int checkLocale(const Locale& loc, const std::vector<double>& values, bool verbose)
+{
+    static const char* names[] = { "decimal", "percent" };
+    int mismatches = 0;
+
+    for (int type = 0; type < 2; ++type) {
+        UErrorCode status = U_ZERO_ERROR;
+        NumberFormat* icu = type ? NumberFormat::createPercentInstance(loc, status)
+                : NumberFormat::createInstance(loc, status);
+        NumberFormat* nf = type ? NumberFormat::createPercentInstance(loc, status)
+                : NumberFormat::createInstance(loc, status);
+        if (!icu || !nf) {
+            delete icu;
+            delete nf;
+            continue;
+        }
+
+        NumberFormatter formatter(nf, false);
+        std::string fast, expected;
+        size_t matched = 0;
+        int localeMismatches = 0;
+
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (!formatter.formatFast(values[i], fast))
+                continue;
+            ++matched;
+
+            UnicodeString ucs;
+            icu->format(values[i], ucs);
+            expected.clear();
+            ucs.toUTF8String(expected);
+            if (fast != expected) {
+                if (localeMismatches < 5)
+                    fprintf(stderr, "%s %s mismatch: %.17g '%s' != '%s'\n", loc.getName(), names[type],
+                            values[i], fast.c_str(), expected.c_str());
+                ++localeMismatches;
+            }
+        }
+
+        double start = now();
+        for (size_t i = 0; i < values.size(); ++i) {
+            UnicodeString ucs;
+            icu->format(values[i], ucs);
+            expected.clear();
+            ucs.toUTF8String(expected);
+        }
+        double icuTime = now() - start;
+
+        start = now();
+        for (size_t i = 0; i < values.size(); ++i)
+            formatter.format(values[i], fast);
+        double fastTime = now() - start;
+
+        if (verbose || localeMismatches) {
+            printf("%-16s %-8s %10.1f %10.1f %9u/%-9u %6d\n", loc.getName(), names[type],
+                    icuTime * 1e9 / values.size(), fastTime * 1e9 / values.size(),
+                    (unsigned) matched, (unsigned) values.size(), localeMismatches);
+        }
+
+        mismatches += localeMismatches;
+        delete icu;
+    }
+
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    int count = 100000;
+    bool all = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-a")) {
+            all = true;
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            UErrorCode status = U_ZERO_ERROR;
+            Locale::setDefault(Locale::createFromName(argv[++i]), status);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        }
+    }
+
+    std::vector<double> values;
+    makeValues(count, values);
+
+    printf("%-16s %-8s %10s %10s %19s %6s\n", "locale", "type", "ICU ns", "fast ns", "fast path", "diff");
+
+    int mismatches = 0;
+    if (all) {
+        int32_t locales = 0;
+        const Locale* list = Locale::getAvailableLocales(locales);
+        for (int32_t i = 0; i < locales; ++i)
+            mismatches += checkLocale(list[i], values, false);
+        printf("%d locales checked, %d mismatches\n", locales, mismatches);
+    } else {
+        mismatches = checkLocale(Locale::getDefault(), values, true);
+    }
+
+    return mismatches ? 1 : 0;
+}
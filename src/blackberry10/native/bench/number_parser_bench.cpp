@@ -0,0 +1,198 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Throughput comparison for the stringToNumber parsers.
+ *
+ * For each number type a corpus of formatted numbers (100k lines by
+ * default) is parsed with a new ICU NumberFormat per string as
+ * stringToNumber used to do, with a cached ICU NumberFormat, and with
+ * NumberParser. Every NumberParser result is checked against ICU.
+ *
+ * usage: number_parser_bench [-l locale] [-n lines]
+ *
+ * Built on a Linux host against the system ICU:
+ *   g++ -O2 -DU_USING_ICU_NAMESPACE=1 -I../../../common number_parser_bench.cpp ../../../common/number_parser.cpp \
+ *       -licui18n -licuuc -o number_parser_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unicode/curramt.h>
+#include <unicode/numfmt.h>
+#include <unicode/parsepos.h>
+#include "number_parser.hpp"
+
+using namespace webworks;
+
+enum ENumberType {
+    kNumberDecimal,
+    kNumberCurrency,
+    kNumberPercent,
+    kNumberTypeCount
+};
+
+static const char* kTypeNames[kNumberTypeCount] = { "decimal", "currency", "percent" };
+
+static const double kMagnitudes[] = { 1, 10, 100, 1e3, 1e4, 1e5, 1e6, 1e7, 1e9 };
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static NumberFormat* createNumberFormat(int type)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    switch (type) {
+    case kNumberDecimal:
+    default:
+        return NumberFormat::createInstance(status);
+    case kNumberCurrency:
+        return NumberFormat::createCurrencyInstance(status);
+    case kNumberPercent:
+        return NumberFormat::createPercentInstance(status);
+    }
+}
+
+static bool parseWithICU(NumberFormat* nf, int type, const std::string& line, double& number)
+{
+    UnicodeString uStr = UnicodeString::fromUTF8(line);
+    UErrorCode status = U_ZERO_ERROR;
+    Formattable value;
+
+    if (type == kNumberCurrency) {
+        ParsePosition pos;
+        CurrencyAmount* ca = nf->parseCurrency(uStr, pos);
+        if (ca) {
+            value = ca->getNumber();
+            delete ca;
+        } else {
+            nf->parse(uStr, value, status);
+        }
+    } else {
+        nf->parse(uStr, value, status);
+    }
+
+    if ((status != U_ZERO_ERROR && status != U_ERROR_WARNING_START) || !value.isNumeric())
+        return false;
+
+    number = value.getDouble(status);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int count = 100000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            UErrorCode status = U_ZERO_ERROR;
+            Locale::setDefault(Locale::createFromName(argv[++i]), status);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        }
+    }
+
+    printf("locale: %s, lines: %d\n", Locale::getDefault().getName(), count);
+    printf("%-10s %14s %14s %14s %10s %10s\n", "type", "ICU/call ns", "ICU cached ns",
+            "parser ns", "matched", "mismatch");
+
+    int failures = 0;
+    for (int type = 0; type < kNumberTypeCount; ++type) {
+        NumberFormat* nf = createNumberFormat(type);
+        if (!nf) {
+            fprintf(stderr, "Failed to create NumberFormat instance!\n");
+            return 1;
+        }
+
+        // Mixed magnitudes, signs and fraction lengths in the locale's format.
+        srand(42);
+        std::vector<std::string> lines;
+        for (int i = 0; i < count; ++i) {
+            double magnitude = kMagnitudes[rand() % 9];
+            double value = (double) rand() / RAND_MAX * magnitude;
+            if (rand() % 4 == 0)
+                value = -value;
+            UnicodeString text;
+            nf->format(value, text);
+            std::string utf8;
+            text.toUTF8String(utf8);
+            lines.push_back(utf8);
+        }
+
+        double number;
+        size_t uncachedLines = lines.size() / 10 + 1;
+        if (uncachedLines > lines.size())
+            uncachedLines = lines.size();
+        double start = now();
+        for (size_t i = 0; i < uncachedLines; ++i) {
+            NumberFormat* fresh = createNumberFormat(type);
+            parseWithICU(fresh, type, lines[i], number);
+            delete fresh;
+        }
+        double uncached = now() - start;
+
+        std::vector<double> expected(lines.size());
+        std::vector<bool> expectedOk(lines.size());
+        start = now();
+        for (size_t i = 0; i < lines.size(); ++i)
+            expectedOk[i] = parseWithICU(nf, type, lines[i], expected[i]);
+        double cached = now() - start;
+
+        NumberParser parser(createNumberFormat(type), type == kNumberCurrency);
+        size_t matched = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (parser.match(lines[i], number))
+                ++matched;
+        }
+
+        std::vector<double> actual(lines.size());
+        std::vector<bool> actualOk(lines.size());
+        start = now();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            UErrorCode status = U_ZERO_ERROR;
+            Formattable value;
+            parser.parse(lines[i], value, status);
+            actualOk[i] = (status == U_ZERO_ERROR || status == U_ERROR_WARNING_START) && value.isNumeric();
+            actual[i] = actualOk[i] ? value.getDouble(status) : 0;
+        }
+        double fast = now() - start;
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (actualOk[i] != expectedOk[i] || (actualOk[i] && memcmp(&actual[i], &expected[i], sizeof(double)))) {
+                if (mismatches < 10)
+                    fprintf(stderr, "%s mismatch: '%s' %.17g != %.17g\n", kTypeNames[type],
+                            lines[i].c_str(), actual[i], expected[i]);
+                ++mismatches;
+            }
+        }
+
+        printf("%-10s %14.1f %14.1f %14.1f %10u %10u\n", kTypeNames[type],
+                uncached * 1e9 / uncachedLines, cached * 1e9 / lines.size(), fast * 1e9 / lines.size(),
+                (unsigned) matched, (unsigned) mismatches);
+
+        failures += mismatches;
+        delete nf;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Input throughput of the batch commands with the numbers sent as a JSON
+ * array and packed as base64 Float64, at 10k, 100k and 1M elements (or
+ * the given counts). "input" is what it takes to turn the arguments into
+ * doubles; "numberToStringBatch" is the whole command through
+ * GlobalizationEngine with compact results.
+ *
+ * usage: packed_input_bench [-n elements]...
+ *
+ * Built by the host CMake build.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <json/reader.h>
+#include "compact_encoding.hpp"
+#include "globalization_engine.hpp"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::string jsonArgs(const std::vector<double>& numbers)
+{
+    std::string args = "{\"numbers\":[";
+    char buffer[32];
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        snprintf(buffer, sizeof(buffer), i ? ",%.17g" : "%.17g", numbers[i]);
+        args.append(buffer);
+    }
+    return args.append("],\"options\":{\"type\":\"decimal\"}}");
+}
+
+static std::string packedArgs(const std::vector<double>& numbers)
+{
+    CompactWriter writer;
+    for (size_t i = 0; i < numbers.size(); ++i)
+        writer.putDouble(numbers[i]);
+    return "{\"numbers\":\"" + base64Encode(writer.bytes()) + "\",\"packing\":\"float64\",\"options\":{\"type\":\"decimal\"}}";
+}
+
+static size_t decodeJson(const std::string& args, std::vector<double>& numbers)
+{
+    Json::Reader reader;
+    Json::Value root;
+    reader.parse(args, root);
+    const Json::Value& array = root["numbers"];
+    numbers.resize(array.size());
+    for (Json::Value::UInt i = 0; i < array.size(); ++i)
+        numbers[i] = array[i].asDouble();
+    return numbers.size();
+}
+
+static size_t decodePacked(const std::string& args, std::vector<double>& numbers)
+{
+    Json::Reader reader;
+    Json::Value root;
+    reader.parse(args, root);
+    const std::string& text = root["numbers"].asString();
+    std::string bytes;
+    base64Decode(text, bytes);
+    numbers.resize(bytes.size() / 8);
+    CompactReader in(bytes);
+    for (size_t i = 0; i < numbers.size(); ++i)
+        in.getDouble(numbers[i]);
+    return numbers.size();
+}
+
+static void run(GlobalizationEngine& engine, size_t count)
+{
+    std::vector<double> numbers;
+    srand(42);
+    for (size_t i = 0; i < count; ++i)
+        numbers.push_back((double) rand() / RAND_MAX * 1e6);
+
+    std::string args[] = { jsonArgs(numbers), packedArgs(numbers) };
+    static const char* names[] = { "json", "packed" };
+    int rounds = count >= 1000000 ? 3 : count >= 100000 ? 10 : 50;
+
+    for (int a = 0; a < 2; ++a) {
+        std::vector<double> decoded;
+        double start = now();
+        for (int r = 0; r < rounds; ++r)
+            (a ? decodePacked : decodeJson)(args[a], decoded);
+        double input = (now() - start) / rounds;
+        // %.17g round trips, so both forms must give back the numbers.
+        if (decoded != numbers) {
+            fprintf(stderr, "%s: decoded values differ\n", names[a]);
+            exit(1);
+        }
+
+        start = now();
+        size_t length = 0;
+        for (int r = 0; r < rounds; ++r)
+            length = engine.numberToStringBatch(args[a], kEncodingCompact).size();
+        double command = (now() - start) / rounds;
+        if (length < count) {
+            fprintf(stderr, "%s: %s\n", names[a], engine.numberToStringBatch(args[a]).substr(0, 200).c_str());
+            exit(1);
+        }
+
+        printf("%9u %-7s %12u %10.1f %12.1f %10.1f\n", (unsigned) count, names[a], (unsigned) args[a].size(),
+                input * 1e9 / count, count / input / 1e6, command * 1e9 / count);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            counts.push_back(atoi(argv[++i]));
+    }
+    if (counts.empty()) {
+        counts.push_back(10000);
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+
+    GlobalizationEngine engine;
+    printf("%9s %-7s %12s %10s %12s %10s\n", "elements", "input", "arg bytes", "input ns", "input Mel/s",
+            "command ns");
+    for (size_t i = 0; i < counts.size(); ++i)
+        run(engine, counts[i]);
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replays a call log recorded by the extension through InvokeFunction and
+ * reports throughput and the latency distribution next to the latencies
+ * seen when the log was recorded.
+ *
+ * A log is recorded by starting the application (or any program loading
+ * the extension) with GLOBALIZATION_RECORD set to a file path. With -t
+ * every thread replays the whole log against its own contexts, so the
+ * threads only contend where the extension shares state. CreateObj,
+ * Dispose and @DestroyContext calls are not replayed; the objects a log uses
+ * are created up front instead. Calls recorded with an object handle
+ * ("InvokeMethod <id> #<handle> ...") are replayed with the handle of the
+ * thread's own object of that id. The exit status is 1 when any replayed
+ * call failed.
+ *
+ * usage: globalization_replay [-t threads] [-r repeat] log
+ *
+ * Built by the host CMake build:
+ *   GLOBALIZATION_RECORD=/tmp/calls.log build/globalization_benchmark
+ *   build/globalization_replay -t 4 /tmp/calls.log
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+#include "call_log.hpp"
+#include "plugin.h"
+
+using namespace webworks;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A recorded InvokeMethod, split around its optional handle token.
+struct Invocation {
+    Invocation(): handle(false) {}
+
+    std::string objId;
+    bool handle;
+    std::string method;
+    // What follows the handle token: the method and its arguments.
+    std::string rest;
+};
+
+static bool parseInvoke(const std::string& command, Invocation& invocation)
+{
+    size_t begin = command.find(' ');
+    if (begin == std::string::npos || command.compare(0, begin, szINVOKE))
+        return false;
+    begin = command.find_first_not_of(' ', begin);
+    if (begin == std::string::npos)
+        return false;
+
+    size_t end = command.find(' ', begin);
+    invocation.objId = command.substr(begin, end - begin);
+    begin = end == std::string::npos ? end : command.find_first_not_of(' ', end);
+    if (begin == std::string::npos)
+        return false;
+
+    invocation.handle = command[begin] == '#';
+    if (invocation.handle) {
+        begin = command.find_first_not_of("0123456789", begin + 1);
+        begin = begin == std::string::npos ? begin : command.find_first_not_of(' ', begin);
+        if (begin == std::string::npos)
+            return false;
+    }
+
+    invocation.rest = command.substr(begin);
+    invocation.method = invocation.rest.substr(0, invocation.rest.find(' '));
+    return true;
+}
+
+struct Replay {
+    const std::vector<CallRecord>* records;
+    const std::vector<bool>* lifecycle;
+    // The commands as this thread sends them, with its own handles.
+    std::vector<std::string> commands;
+    int thread;
+    int repeat;
+    pthread_barrier_t* barrier;
+    std::vector<double> latencies;
+    unsigned long errors;
+};
+
+// Each thread gets its own set of contexts, keyed by the recorded ones.
+static void* context(int thread, unsigned int recorded)
+{
+    return (void*) (((size_t) (thread + 1) << 20) | recorded);
+}
+
+static void* replayThread(void* arg)
+{
+    Replay* replay = static_cast<Replay*>(arg);
+    const std::vector<CallRecord>& records = *replay->records;
+    const std::vector<bool>& lifecycle = *replay->lifecycle;
+
+    pthread_barrier_wait(replay->barrier);
+    for (int r = 0; r < replay->repeat; ++r) {
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (lifecycle[i])
+                continue;
+
+            double start = now();
+            const char* result = InvokeFunction(replay->commands[i].c_str(),
+                    context(replay->thread, records[i].context));
+            replay->latencies.push_back(now() - start);
+
+            if (!strncmp(result, szERROR, strlen(szERROR)) || !strncmp(result, "{\"error\"", 8))
+                ++replay->errors;
+        }
+    }
+    return NULL;
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printLatencies(const char* label, std::vector<double>& latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f\n", label,
+            percentile(latencies, 0.5) * 1e6, percentile(latencies, 0.9) * 1e6,
+            percentile(latencies, 0.99) * 1e6, percentile(latencies, 0.999) * 1e6,
+            latencies.empty() ? 0 : latencies.back() * 1e6);
+}
+
+static void onEvent(const char*, void*)
+{
+}
+
+int main(int argc, char** argv)
+{
+    int threads = 1;
+    int repeat = 1;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else
+            path = argv[i];
+    }
+
+    if (!path || threads < 1 || repeat < 1) {
+        fprintf(stderr, "usage: globalization_replay [-t threads] [-r repeat] log\n");
+        return 2;
+    }
+
+    std::vector<CallRecord> records;
+    std::string error;
+    if (!readCallLog(path, records, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // "CreateObj <class> <id>" or "InvokeMethod <id> [#<handle>] ..." per
+    // recorded context.
+    typedef std::pair<unsigned int, std::string> ObjectKey;
+    std::set<ObjectKey> objects;
+    std::vector<Invocation> invocations(records.size());
+    std::vector<bool> lifecycle(records.size(), false);
+    std::vector<double> recorded;
+    for (size_t i = 0; i < records.size(); ++i) {
+        std::vector<std::string> tokens;
+        g_tokenize(records[i].command, " ", tokens);
+        if (tokens.size() >= 3 && tokens[0] == szCREATE) {
+            objects.insert(std::make_pair(records[i].context, tokens[2]));
+            lifecycle[i] = true;
+        } else if (parseInvoke(records[i].command, invocations[i])) {
+            objects.insert(std::make_pair(records[i].context, invocations[i].objId));
+            lifecycle[i] = invocations[i].method == szDISPOSE || invocations[i].method == szDESTROYCONTEXT;
+        }
+
+        if (!lifecycle[i])
+            recorded.push_back(records[i].duration / 1e9);
+    }
+
+    SetEventFunc(onEvent);
+    std::vector<Replay> replays(threads);
+    for (int t = 0; t < threads; ++t) {
+        // Recorded handles belong to objects that no longer exist, so each
+        // is replaced by the handle of the object this thread created for
+        // the same context and id.
+        std::map<ObjectKey, std::string> handles;
+        std::set<ObjectKey>::iterator iter;
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            std::string create = std::string(szCREATE) + " Globalization " + iter->second;
+            InvokeFunction(create.c_str(), context(t, iter->first));
+
+            std::string query = std::string(szINVOKE) + " " + iter->second + " " + szHANDLE;
+            const char* reply = InvokeFunction(query.c_str(), context(t, iter->first));
+            if (!strncmp(reply, szOK, strlen(szOK)))
+                handles[*iter] = reply + strlen(szOK);
+        }
+
+        replays[t].commands.resize(records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            const Invocation& invocation = invocations[i];
+            if (!invocation.handle) {
+                replays[t].commands[i] = records[i].command;
+                continue;
+            }
+
+            replays[t].commands[i] = std::string(szINVOKE) + " " + invocation.objId + " #"
+                    + handles[std::make_pair(records[i].context, invocation.objId)] + " " + invocation.rest;
+        }
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads + 1);
+
+    std::vector<pthread_t> ids(threads);
+    for (int t = 0; t < threads; ++t) {
+        replays[t].records = &records;
+        replays[t].lifecycle = &lifecycle;
+        replays[t].thread = t;
+        replays[t].repeat = repeat;
+        replays[t].barrier = &barrier;
+        replays[t].errors = 0;
+        pthread_create(&ids[t], NULL, replayThread, &replays[t]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    double start = now();
+    for (int t = 0; t < threads; ++t)
+        pthread_join(ids[t], NULL);
+    double elapsed = now() - start;
+    pthread_barrier_destroy(&barrier);
+
+    std::vector<double> latencies;
+    unsigned long errors = 0;
+    for (int t = 0; t < threads; ++t) {
+        latencies.insert(latencies.end(), replays[t].latencies.begin(), replays[t].latencies.end());
+        errors += replays[t].errors;
+    }
+
+    printf("%u calls recorded, %u objects, %d threads x %d\n", (unsigned) records.size(),
+            (unsigned) objects.size(), threads, repeat);
+    printf("%u calls replayed in %.3f s, %.0f calls/s, %lu errors\n", (unsigned) latencies.size(),
+            elapsed, latencies.size() / elapsed, errors);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "us", "p50", "p90", "p99", "p99.9", "max");
+    printLatencies("recorded", recorded);
+    printLatencies("replayed", latencies);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Differential check and benchmark for the DST transition tables.
+ *
+ * For every zone ICU knows (or the given one) a table is built for the
+ * window, and random dates inside it plus the instants around every
+ * transition are answered by the table and by TimeZone::getOffset. Any
+ * difference is reported. Lookup timings of both are printed at the end.
+ *
+ * usage: transition_table_bench [-z zone] [-w first last] [-n dates]
+ *
+ * Built on a Linux host against the system ICU:
+ *   g++ -O2 -DU_USING_ICU_NAMESPACE=1 -I../../../common transition_table_bench.cpp ../../../common/transition_table.cpp \
+ *       -licui18n -licuuc -o transition_table_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unicode/strenum.h>
+#include <unicode/tztrans.h>
+#include <unicode/vtzone.h>
+#include "transition_table.hpp"
+
+using namespace webworks;
+
+static const double kMillisPerYear = 365.2425 * 86400000.0;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static UDate yearStart(int year)
+{
+    return (year - 1970) * kMillisPerYear;
+}
+
+int main(int argc, char** argv)
+{
+    int firstYear = 1970, lastYear = 2037;
+    int count = 10000;
+    std::vector<std::string> zones;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-z") && i + 1 < argc) {
+            zones.push_back(argv[++i]);
+        } else if (!strcmp(argv[i], "-w") && i + 2 < argc) {
+            firstYear = atoi(argv[++i]);
+            lastYear = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        }
+    }
+
+    if (zones.empty()) {
+        std::auto_ptr<StringEnumeration> ids(TimeZone::createEnumeration());
+        UErrorCode status = U_ZERO_ERROR;
+        const char* id;
+        while ((id = ids->next(NULL, status)))
+            zones.push_back(id);
+    }
+
+    // Slightly wider than the window, so the fallback edges are covered.
+    srand(42);
+    std::vector<UDate> dates(count);
+    UDate from = yearStart(firstYear - 1), to = yearStart(lastYear + 2);
+    for (int i = 0; i < count; ++i)
+        dates[i] = from + (double) rand() / RAND_MAX * (to - from);
+
+    double icuTime = 0, tableTime = 0, buildTime = 0;
+    size_t lookups = 0, transitions = 0, mismatches = 0;
+    volatile int32_t sink = 0;
+
+    for (size_t z = 0; z < zones.size(); ++z) {
+        std::auto_ptr<TimeZone> tz(TimeZone::createTimeZone(UnicodeString::fromUTF8(zones[z])));
+
+        double start = now();
+        TransitionTable table(*tz, firstYear, lastYear);
+        buildTime += now() - start;
+        transitions += table.size();
+
+        // Instants just before, at and after each transition ICU reports.
+        std::vector<UDate> probes(dates);
+        UErrorCode status = U_ZERO_ERROR;
+        std::auto_ptr<VTimeZone> vtz(VTimeZone::createVTimeZoneByID(UnicodeString::fromUTF8(zones[z])));
+        TimeZoneTransition transition;
+        for (UDate t = from; vtz.get() && vtz->getNextTransition(t, false, transition) && t < to; ) {
+            t = transition.getTime();
+            probes.push_back(t - 1);
+            probes.push_back(t);
+            probes.push_back(t + 1);
+        }
+
+        for (size_t i = 0; i < probes.size(); ++i) {
+            int32_t raw, dst, icuRaw, icuDst;
+            if (!table.lookup(probes[i], raw, dst))
+                continue;
+            tz->getOffset(probes[i], false, icuRaw, icuDst, status);
+            if (raw != icuRaw || dst != icuDst) {
+                if (mismatches < 10)
+                    fprintf(stderr, "%s mismatch at %.0f: %d/%d != %d/%d\n", zones[z].c_str(),
+                            probes[i], raw, dst, icuRaw, icuDst);
+                ++mismatches;
+            }
+        }
+
+        start = now();
+        for (size_t i = 0; i < dates.size(); ++i) {
+            int32_t raw, dst;
+            tz->getOffset(dates[i], false, raw, dst, status);
+            sink += dst;
+        }
+        icuTime += now() - start;
+
+        start = now();
+        for (size_t i = 0; i < dates.size(); ++i) {
+            int32_t raw, dst;
+            if (!table.lookup(dates[i], raw, dst))
+                tz->getOffset(dates[i], false, raw, dst, status);
+            sink += dst;
+        }
+        tableTime += now() - start;
+        lookups += dates.size();
+    }
+
+    printf("zones: %u, window: %d-%d, transitions: %u\n", (unsigned) zones.size(), firstYear, lastYear,
+            (unsigned) transitions);
+    printf("build: %.1f us/zone, ICU: %.1f ns/query, table: %.1f ns/query, mismatches: %u\n",
+            buildTime * 1e6 / zones.size(), icuTime * 1e9 / lookups, tableTime * 1e9 / lookups,
+            (unsigned) mismatches);
+
+    return mismatches ? 1 : 0;
+}
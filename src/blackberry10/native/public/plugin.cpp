@@ -17,6 +17,11 @@
 
 #include "plugin.h"
 #include "tokenizer.h"
+#include "call_log.hpp"
+#include "probes.hpp"
+#include "tick_clock.hpp"
+#include "trace.hpp"
+#include <stdio.h>
 
 #ifdef _WINDOWS
 #include <windows.h>
@@ -28,6 +33,8 @@ BOOL APIENTRY DllMain( HANDLE hModule,
 }
 #else
 #include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 
 extern int errno;
@@ -110,54 +117,151 @@ char* SetEventFunc( SendPluginEv funcPtr )
 
 
 const int nMAXSIZE = 512;
-char* g_pszRetVal = NULL;
+
+// Every thread gets its own return buffer so that calls can overlap.
+pthread_key_t g_retValKey;
+
+// Guards the maps below. Objects are invoked without it, pinned by
+// their slot's call count so that a Dispose on another thread leaves
+// the delete to the last call out.
+pthread_mutex_t g_contextLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Set GLOBALIZATION_RECORD to a file path to log every call for replay.
+webworks::CallLogWriter* g_pCallLog = NULL;
+
+//-----------------------------------------------------------
+// Objects live in a dense slot vector and are addressed by an
+// integer handle: the slot index in the low bits and the slot's
+// generation above it, so a handle kept after Dispose no longer
+// resolves once the slot is reused.
+//-----------------------------------------------------------
+const unsigned int nHANDLE_INDEX_BITS = 16;
+const unsigned int nHANDLE_INDEX_MASK = ( 1u << nHANDLE_INDEX_BITS ) - 1;
+
+struct ObjectSlot
+{
+    JSExt* pJSExt;              // NULL while the slot is free
+    void* pContext;
+    unsigned int nGeneration;
+    unsigned int nCalls;        // InvokeMethod calls in progress
+    bool bRetired;              // disposed while nCalls > 0
+    bool bDeleteWhenIdle;
+    string strObjId;
+};
+
+vector<ObjectSlot> g_slots;
+vector<unsigned int> g_freeSlots;
 
 //-----------------------------------------------------------
-// Map from an object Id to an object instance
+// Map from an object Id to its handle, for callers that
+// address objects by the id given to CreateObj
 //-----------------------------------------------------------
-typedef std::map<string, JSExt*> StringToJExt_T;
+typedef std::map<string, unsigned int> StringToHandle_T;
 
 //-----------------------------------------------------------
 // Map from a browser context to an id mapping
 //-----------------------------------------------------------
-typedef std::map<void*, StringToJExt_T*> VoidToMap_T;
+typedef std::map<void*, StringToHandle_T*> VoidToMap_T;
 
 VoidToMap_T g_context2Map;
 
+//-----------------------------------------------------------
+// A context's registry is dropped once its last object goes
+// away and kept here for the next context, so contexts that
+// come and go don't grow the heap.
+//-----------------------------------------------------------
+const size_t nMAX_POOLED_MAPS = 8;
+
+vector<StringToHandle_T*> g_pooledMaps;
+
+class ContextLock
+{
+public:
+    ContextLock( void ) : m_bLocked( true )
+    {
+        pthread_mutex_lock( &g_contextLock );
+    }
+
+    ~ContextLock()
+    {
+        Release();
+    }
+
+    void Release( void )
+    {
+        if ( m_bLocked )
+        {
+            pthread_mutex_unlock( &g_contextLock );
+            m_bLocked = false;
+        }
+    }
+
+private:
+    bool m_bLocked;
+};
+
+static void deleteRetVal( void* pszRetVal )
+{
+    delete [] static_cast<char*>( pszRetVal );
+}
+
 class GlobalSharedModule
 {
 
 public:
     GlobalSharedModule( void )
     {
-        g_pszRetVal = new char[ nMAXSIZE ];
+        pthread_key_create( &g_retValKey, deleteRetVal );
+        g_pCallLog = webworks::CallLogWriter::open( getenv( "GLOBALIZATION_RECORD" ) );
     }
 
     ~GlobalSharedModule()
     {
-        delete [] g_pszRetVal;
+        delete g_pCallLog;
+        g_pCallLog = NULL;
 
-        VoidToMap_T::iterator posMaps;
+        // Other threads' buffers can't be reached from here, but the key
+        // must not outlive the library: a thread exiting after the unload
+        // would call deleteRetVal in unmapped code.
+        deleteRetVal( pthread_getspecific( g_retValKey ) );
+        pthread_setspecific( g_retValKey, NULL );
+        pthread_key_delete( g_retValKey );
 
-        for ( posMaps = g_context2Map.begin(); posMaps != g_context2Map.end(); ++posMaps )
-        {
-            StringToJExt_T& id2Obj = *posMaps->second;
-            StringToJExt_T::iterator posMap;
+        vector<ObjectSlot>::iterator posSlot;
 
-            for ( posMap = id2Obj.begin(); posMap != id2Obj.end(); ++posMap )
+        for ( posSlot = g_slots.begin(); posSlot != g_slots.end(); ++posSlot )
+        {
+            if ( posSlot->pJSExt == NULL )
             {
-                JSExt* pJSExt = posMap->second;
+                continue;
+            }
 
-                if ( pJSExt->CanDelete() )
-                {
-                    delete pJSExt;
-                }
+            if ( posSlot->bRetired ? posSlot->bDeleteWhenIdle : posSlot->pJSExt->CanDelete() )
+            {
+                delete posSlot->pJSExt;
             }
+        }
 
-            id2Obj.erase( id2Obj.begin(), id2Obj.end() );
+        g_slots.clear();
+        g_freeSlots.clear();
+
+        VoidToMap_T::iterator posMaps;
+
+        for ( posMaps = g_context2Map.begin(); posMaps != g_context2Map.end(); ++posMaps )
+        {
+            delete posMaps->second;
         }
 
         g_context2Map.erase( g_context2Map.begin(), g_context2Map.end() );
+
+        vector<StringToHandle_T*>::iterator posPooled;
+
+        for ( posPooled = g_pooledMaps.begin(); posPooled != g_pooledMaps.end(); ++posPooled )
+        {
+            delete *posPooled;
+        }
+
+        g_pooledMaps.clear();
     }
 };
 
@@ -166,23 +270,248 @@ GlobalSharedModule g_sharedModule;
 char* g_str2global( const string& strRetVal )
 {
     int nLen = strRetVal.size();
+    char* pszRetVal = static_cast<char*>( pthread_getspecific( g_retValKey ) );
 
     if ( nLen >= nMAXSIZE )
     {
-        delete [] g_pszRetVal;
-        g_pszRetVal = new char[ nLen + 1 ];
+        delete [] pszRetVal;
+        pszRetVal = new char[ nLen + 1 ];
     }
 
     else
     {
         // To minimaize the number of memory reallocations, the assumption
         // is that in most times this will be the case
-        delete [] g_pszRetVal;
-        g_pszRetVal = new char[ nMAXSIZE ];
+        delete [] pszRetVal;
+        pszRetVal = new char[ nMAXSIZE ];
     }
 
-    strcpy( g_pszRetVal, strRetVal.c_str() );
-    return g_pszRetVal;
+    pthread_setspecific( g_retValKey, pszRetVal );
+    strcpy( pszRetVal, strRetVal.c_str() );
+    return pszRetVal;
+}
+
+// The slot functions below are called with g_contextLock held.
+// Returns 0 when every handle index is in use.
+static unsigned int allocSlot( JSExt* pJSExt, void* pContext, const string& strObjId )
+{
+    unsigned int nIndex;
+
+    if ( g_freeSlots.empty() )
+    {
+        if ( g_slots.size() > nHANDLE_INDEX_MASK )
+        {
+            return 0;
+        }
+
+        nIndex = g_slots.size();
+        ObjectSlot slot;
+        slot.nGeneration = 1;
+        g_slots.push_back( slot );
+    }
+    else
+    {
+        nIndex = g_freeSlots.back();
+        g_freeSlots.pop_back();
+    }
+
+    ObjectSlot& slot = g_slots[ nIndex ];
+    slot.pJSExt = pJSExt;
+    slot.pContext = pContext;
+    slot.nCalls = 0;
+    slot.bRetired = false;
+    slot.bDeleteWhenIdle = false;
+    slot.strObjId = strObjId;
+    return ( slot.nGeneration << nHANDLE_INDEX_BITS ) | nIndex;
+}
+
+static ObjectSlot* findSlot( unsigned int nHandle, void* pContext )
+{
+    unsigned int nIndex = nHandle & nHANDLE_INDEX_MASK;
+
+    if ( nIndex >= g_slots.size() )
+    {
+        return NULL;
+    }
+
+    ObjectSlot& slot = g_slots[ nIndex ];
+
+    if ( slot.pJSExt == NULL || slot.bRetired || slot.pContext != pContext
+         || ( ( slot.nGeneration << nHANDLE_INDEX_BITS ) | nIndex ) != nHandle )
+    {
+        return NULL;
+    }
+
+    return &slot;
+}
+
+static void freeSlot( unsigned int nIndex )
+{
+    ObjectSlot& slot = g_slots[ nIndex ];
+
+    slot.pJSExt = NULL;
+    slot.pContext = NULL;
+    slot.bRetired = false;
+    slot.strObjId.clear();
+    g_freeSlots.push_back( nIndex );
+}
+
+// Disposes the object at nHandle. The handle goes stale right away;
+// while the object is still in a call, the slot waits for unpinSlot.
+// Returns the object when it is to be deleted now, that is if bDelete,
+// the object allows it and it is idle. The caller deletes it after
+// releasing g_contextLock, since a destructor may wait for the object's
+// own threads and must not hold up every other call meanwhile.
+static JSExt* retireSlot( unsigned int nHandle, bool bDelete )
+{
+    unsigned int nIndex = nHandle & nHANDLE_INDEX_MASK;
+    ObjectSlot& slot = g_slots[ nIndex ];
+
+    bDelete = bDelete && slot.pJSExt->CanDelete();
+
+    // Generation 0 is never handed out, so no handle is ever 0.
+    slot.nGeneration = ( slot.nGeneration + 1 ) & ( ~0u >> nHANDLE_INDEX_BITS );
+    if ( slot.nGeneration == 0 )
+    {
+        slot.nGeneration = 1;
+    }
+
+    if ( slot.nCalls > 0 )
+    {
+        slot.bRetired = true;
+        slot.bDeleteWhenIdle = bDelete;
+        return NULL;
+    }
+
+    JSExt* pDeleted = bDelete ? slot.pJSExt : NULL;
+    freeSlot( nIndex );
+    return pDeleted;
+}
+
+// Returns the object when its last call out leaves it to be deleted,
+// for the caller to delete as with retireSlot.
+static JSExt* unpinSlot( unsigned int nIndex )
+{
+    ObjectSlot& slot = g_slots[ nIndex ];
+
+    if ( --slot.nCalls > 0 || !slot.bRetired )
+    {
+        return NULL;
+    }
+
+    JSExt* pDeleted = slot.bDeleteWhenIdle ? slot.pJSExt : NULL;
+    freeSlot( nIndex );
+    return pDeleted;
+}
+
+// Deletes the objects the slot functions hand back, without g_contextLock.
+static void deleteObjects( const vector<JSExt*>& objects )
+{
+    vector<JSExt*>::const_iterator pos;
+
+    for ( pos = objects.begin(); pos != objects.end(); ++pos )
+    {
+        delete *pos;
+    }
+}
+
+static StringToHandle_T* acquireMap( void* pContext )
+{
+    StringToHandle_T* pID2Handle;
+
+    if ( g_pooledMaps.empty() )
+    {
+        pID2Handle = new StringToHandle_T;
+    }
+    else
+    {
+        pID2Handle = g_pooledMaps.back();
+        g_pooledMaps.pop_back();
+    }
+
+    g_context2Map[ pContext ] = pID2Handle;
+    return pID2Handle;
+}
+
+static void releaseMap( VoidToMap_T::iterator iter )
+{
+    StringToHandle_T* pID2Handle = iter->second;
+    g_context2Map.erase( iter );
+    pID2Handle->clear();
+
+    if ( g_pooledMaps.size() < nMAX_POOLED_MAPS )
+    {
+        g_pooledMaps.push_back( pID2Handle );
+    }
+    else
+    {
+        delete pID2Handle;
+    }
+}
+
+// Returns the number of objects disposed and adds those to delete to
+// deleted, as with retireSlot.
+static unsigned int destroyContext( void* pContext, vector<JSExt*>& deleted )
+{
+    VoidToMap_T::iterator iter = g_context2Map.find( pContext );
+
+    if ( iter == g_context2Map.end() )
+    {
+        return 0;
+    }
+
+    unsigned int nDisposed = 0;
+    StringToHandle_T::iterator pos;
+
+    for ( pos = iter->second->begin(); pos != iter->second->end(); ++pos )
+    {
+        JSExt* pDeleted = retireSlot( pos->second, true );
+
+        if ( pDeleted != NULL )
+        {
+            deleted.push_back( pDeleted );
+        }
+
+        ++nDisposed;
+    }
+
+    releaseMap( iter );
+    return nDisposed;
+}
+
+static string countsToString( void )
+{
+    char szCounts[ 80 ];
+    snprintf( szCounts, sizeof( szCounts ), "{\"objects\":%u,\"contexts\":%u,\"pooled\":%u}",
+              ( unsigned int ) ( g_slots.size() - g_freeSlots.size() ),
+              ( unsigned int ) g_context2Map.size(),
+              ( unsigned int ) g_pooledMaps.size() );
+    return szCounts;
+}
+
+// Returns the space separated token at pCursor and moves past it.
+static string nextToken( const char*& pCursor )
+{
+    while ( *pCursor == ' ' )
+    {
+        ++pCursor;
+    }
+
+    const char* pStart = pCursor;
+
+    while ( *pCursor != ' ' && *pCursor != '\0' )
+    {
+        ++pCursor;
+    }
+
+    return string( pStart, pCursor - pStart );
+}
+
+static string unsignedToString( unsigned int nValue )
+{
+    char szValue[ 16 ];
+    snprintf( szValue, sizeof( szValue ), "%u", nValue );
+    return szValue;
 }
 
 bool g_unregisterObject( const string& strObjId, void* pContext )
@@ -190,64 +519,83 @@ bool g_unregisterObject( const string& strObjId, void* pContext )
     // Called by the plugin extension implementation
     // if the extension handles the deletion of its object
 
-    StringToJExt_T * pID2Obj = NULL;
+    ContextLock lock;
+    StringToHandle_T * pID2Handle = NULL;
 
     VoidToMap_T::iterator iter = g_context2Map.find( pContext );
 
     if ( iter != g_context2Map.end() )
     {
-        pID2Obj = iter->second;
+        pID2Handle = iter->second;
     }
     else
     {
         return false;
     }
 
-    StringToJExt_T& mapID2Obj = *pID2Obj;
+    StringToHandle_T& mapID2Handle = *pID2Handle;
 
-    StringToJExt_T::iterator r = mapID2Obj.find( strObjId );
+    StringToHandle_T::iterator r = mapID2Handle.find( strObjId );
 
-    if ( r == mapID2Obj.end() )
+    if ( r == mapID2Handle.end() )
     {
         return false;
     }
 
-    mapID2Obj.erase( strObjId );
+    retireSlot( r->second, false );
+    mapID2Handle.erase( r );
+
+    if ( mapID2Handle.empty() )
+    {
+        releaseMap( iter );
+    }
+
     return true;
 }
 
-char* InvokeFunction( const char* szCommand, void* pContext )
+unsigned int g_destroyContext( void* pContext )
 {
-    StringToJExt_T * pID2Obj = NULL;
-
-    VoidToMap_T::iterator iter = g_context2Map.find( pContext );
+    vector<JSExt*> deleted;
+    unsigned int nDisposed;
 
-    if ( iter != g_context2Map.end() )
-    {
-        pID2Obj = iter->second;
-    }
-    else
     {
-        pID2Obj = new StringToJExt_T;
-        g_context2Map[ pContext ] = pID2Obj;
+        ContextLock lock;
+        nDisposed = destroyContext( pContext, deleted );
     }
 
-    StringToJExt_T& mapID2Obj = *pID2Obj;
+    deleteObjects( deleted );
+    return nDisposed;
+}
+
+void g_getObjectCounts( unsigned int& nObjects, unsigned int& nContexts, unsigned int& nPooled )
+{
+    ContextLock lock;
+    nObjects = g_slots.size() - g_freeSlots.size();
+    nContexts = g_context2Map.size();
+    nPooled = g_pooledMaps.size();
+}
+
+// Commands are "CreateObj <class> <id>" and "InvokeMethod <id> <method> ...".
+// An invoke may put "#<handle>" after the id, as returned by the @Handle
+// method, to reach the object without looking the id up. Methods starting
+// with '@' are the plugin's own and never reach an extension. A context
+// takes a registry with its first object and gives it back with its last.
+static char* invokeCommand( const char* szCommand, void* pContext )
+{
+    ContextLock lock;
+    VoidToMap_T::iterator iter = g_context2Map.find( pContext );
+    bool bNewContext = ( iter == g_context2Map.end() );
 
-    string strFullCommand = szCommand;
-    vector<string> arParams;
-    g_tokenize( strFullCommand, " ", arParams );
-    string strCommand = arParams[ 0 ];
+    const char* pCursor = szCommand;
+    string strCommand = nextToken( pCursor );
     string strRetVal = szERROR;
 
     if ( strCommand == szCREATE )
     {
-        string strClassName = arParams[ 1 ];
-        string strObjId = arParams[ 2 ];
+        string strClassName = nextToken( pCursor );
+        string strObjId = nextToken( pCursor );
 
-        StringToJExt_T::iterator r = mapID2Obj.find( strObjId );
-
-        if ( r != mapID2Obj.end() )
+        if ( !bNewContext && iter->second->count( strObjId ) )
         {
             strRetVal += strObjId;
             strRetVal += " :Object already exists.";
@@ -265,7 +613,24 @@ char* InvokeFunction( const char* szCommand, void* pContext )
         }
 
         pJSExt->m_pContext = pContext;
-        mapID2Obj[ strObjId ] = pJSExt;
+        unsigned int nHandle = allocSlot( pJSExt, pContext, strObjId );
+
+        if ( nHandle == 0 )
+        {
+            lock.Release();
+
+            if ( pJSExt->CanDelete() )
+            {
+                delete pJSExt;
+            }
+
+            strRetVal += strObjId;
+            strRetVal += " :Too many objects.";
+            return g_str2global( strRetVal );
+        }
+
+        StringToHandle_T* pID2Handle = bNewContext ? acquireMap( pContext ) : iter->second;
+        ( *pID2Handle )[ strObjId ] = nHandle;
 
         strRetVal = szOK;
         strRetVal += strObjId;
@@ -274,57 +639,115 @@ char* InvokeFunction( const char* szCommand, void* pContext )
     else
     if ( strCommand == szINVOKE )
     {
-        string strObjId = arParams[ 1 ];
-        string strMethod = arParams[ 2 ];
+        string strObjId = nextToken( pCursor );
+        unsigned int nHandle;
+        ObjectSlot* pSlot;
 
-        StringToJExt_T::iterator r = mapID2Obj.find( strObjId );
-
-        if ( r == mapID2Obj.end() )
+        while ( *pCursor == ' ' )
         {
-            strRetVal += strObjId;
-            strRetVal += " :No object found for id.";
-            return g_str2global( strRetVal );
+            ++pCursor;
         }
 
-        JSExt* pJSExt = r->second;
-
-        size_t nLoc = strFullCommand.find( strObjId );
-
-        if ( nLoc == string::npos )
+        if ( *pCursor == '#' )
         {
-            strRetVal += strObjId;
-            strRetVal += " :Internal InvokeMethod error.";
-            return g_str2global( strRetVal );
-        }
+            char* pEnd;
+            nHandle = strtoul( pCursor + 1, &pEnd, 10 );
+            pCursor = pEnd;
+            pSlot = findSlot( nHandle, pContext );
 
-        if ( strMethod == szDISPOSE )
+            if ( pSlot == NULL || pSlot->strObjId != strObjId )
+            {
+                strRetVal += strObjId;
+                strRetVal += " :Stale object handle.";
+                return g_str2global( strRetVal );
+            }
+        }
+        else
         {
-            StringToJExt_T::iterator r = mapID2Obj.find( strObjId );
+            StringToHandle_T::iterator r;
 
-            if ( r == mapID2Obj.end() )
+            if ( bNewContext || ( r = iter->second->find( strObjId ) ) == iter->second->end() )
             {
-                strRetVal = szERROR;
                 strRetVal += strObjId;
+                strRetVal += " :No object found for id.";
                 return g_str2global( strRetVal );
             }
 
-            JSExt * pJSExt = mapID2Obj[ strObjId ];
+            nHandle = r->second;
+            pSlot = findSlot( nHandle, pContext );
+        }
+
+        const char* pInvoke = pCursor;
+        string strMethod = nextToken( pCursor );
 
-            if ( pJSExt->CanDelete() )
+        if ( strMethod == szDISPOSE )
+        {
+            JSExt* pDeleted = retireSlot( nHandle, true );
+            iter->second->erase( strObjId );
+
+            if ( iter->second->empty() )
             {
-                delete pJSExt;
+                releaseMap( iter );
             }
 
-            mapID2Obj.erase( strObjId );
+            lock.Release();
+            delete pDeleted;
+
+            strRetVal = szOK;
+            strRetVal += strObjId;
+            return g_str2global( strRetVal );
+        }
+
+        if ( strMethod == szHANDLE )
+        {
+            strRetVal = szOK;
+            strRetVal += unsignedToString( nHandle );
+            return g_str2global( strRetVal );
+        }
+
+        if ( strMethod == szCOUNTS )
+        {
             strRetVal = szOK;
+            strRetVal += countsToString();
+            return g_str2global( strRetVal );
+        }
+
+        // Disposes the invoked object along with the rest of its context.
+        if ( strMethod == szDESTROYCONTEXT )
+        {
+            vector<JSExt*> deleted;
+            strRetVal = szOK;
+            strRetVal += unsignedToString( destroyContext( pContext, deleted ) );
+            lock.Release();
+            deleteObjects( deleted );
+            return g_str2global( strRetVal );
+        }
+
+        if ( strMethod[ 0 ] == cBUILTIN )
+        {
             strRetVal += strObjId;
+            strRetVal += " :Unknown method ";
+            strRetVal += strMethod;
             return g_str2global( strRetVal );
         }
 
-        size_t nSuffixLoc = nLoc + strObjId.size();
-        string strInvoke = strFullCommand.substr( nSuffixLoc );
+        JSExt* pJSExt = pSlot->pJSExt;
+        unsigned int nIndex = nHandle & nHANDLE_INDEX_MASK;
+        string strInvoke = pInvoke;
         strInvoke = g_trim( strInvoke );
+        ++pSlot->nCalls;
+        lock.Release();
         strRetVal = pJSExt->InvokeMethod( strInvoke );
+
+        JSExt* pDeleted;
+
+        {
+            ContextLock unpinLock;
+            pDeleted = unpinSlot( nIndex );
+        }
+
+        delete pDeleted;
+
         return g_str2global( strRetVal );
     }
 
@@ -333,5 +756,24 @@ char* InvokeFunction( const char* szCommand, void* pContext )
     return g_str2global( strRetVal );
 }
 
+char* InvokeFunction( const char* szCommand, void* pContext )
+{
+    webworks::TraceSpan span( "InvokeFunction", "jnext" );
+    GLOBALIZATION_PROBE( invoke__entry, -1, strlen( szCommand ), 0 );
+
+    unsigned long long start = g_pCallLog ? webworks::TickClock::monotonicNanos() : 0;
+
+    char* szRetVal = invokeCommand( szCommand, pContext );
+
+    if ( g_pCallLog != NULL )
+    {
+        g_pCallLog->write( szCommand, pContext, start, webworks::TickClock::monotonicNanos() );
+    }
+
+    GLOBALIZATION_PROBE( invoke__return, -1, strlen( szRetVal ),
+            strncmp( szRetVal, szERROR, sizeof( szERROR ) - 1 ) == 0 );
+    return szRetVal;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
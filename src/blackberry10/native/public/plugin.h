@@ -50,6 +50,13 @@ extern SendPluginEv SendPluginEvent;
 #define szOK            "Ok "
 
 #define szDISPOSE       "Dispose"
+
+// Methods the plugin answers itself carry a prefix that extension
+// methods may not start with, so they never hide one of those.
+#define cBUILTIN        '@'
+#define szHANDLE        "@Handle"
+#define szCOUNTS        "@Counts"
+#define szDESTROYCONTEXT "@DestroyContext"
 #define szINVOKE        "InvokeMethod"
 #define szCREATE        "CreateObj"
 
@@ -61,6 +68,10 @@ void g_tokenize(const string& str,const string& delimiters, vector<string>& toke
 char* g_str2static( const string& strRetVal );
 void g_sleep( unsigned int mseconds );
 bool g_unregisterObject( const string& strObjId, void* pContext );
+// Disposes every object created in the browser context and drops the
+// context's registry; returns the number of objects disposed.
+unsigned int g_destroyContext( void* pContext );
+void g_getObjectCounts( unsigned int& nObjects, unsigned int& nContexts, unsigned int& nPooled );
 
 
 /////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,138 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include "call_log.hpp"
+
+namespace webworks {
+
+static const char kMagic[8] = { 'J', 'N', 'X', 'T', 'L', 'O', 'G', '1' };
+static const size_t kHeaderBytes = 20;
+
+static void put32(unsigned char* p, unsigned int value)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = (unsigned char) (value >> (i * 8));
+}
+
+static void put64(unsigned char* p, unsigned long long value)
+{
+    for (int i = 0; i < 8; ++i)
+        p[i] = (unsigned char) (value >> (i * 8));
+}
+
+static unsigned int get32(const unsigned char* p)
+{
+    unsigned int value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+static unsigned long long get64(const unsigned char* p)
+{
+    unsigned long long value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+CallLogWriter* CallLogWriter::open(const char* path)
+{
+    if (!path || !*path)
+        return NULL;
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return NULL;
+
+    if (fwrite(kMagic, sizeof(kMagic), 1, file) != 1) {
+        fclose(file);
+        return NULL;
+    }
+    return new CallLogWriter(file);
+}
+
+CallLogWriter::CallLogWriter(FILE* file)
+    : m_file(file)
+    , m_origin(0)
+    , m_started(false)
+{
+    pthread_mutex_init(&m_lock, NULL);
+}
+
+CallLogWriter::~CallLogWriter()
+{
+    fclose(m_file);
+    pthread_mutex_destroy(&m_lock);
+}
+
+void CallLogWriter::write(const char* command, const void* context, unsigned long long start, unsigned long long end)
+{
+    size_t length = strlen(command);
+
+    pthread_mutex_lock(&m_lock);
+    if (!m_started) {
+        m_origin = start;
+        m_started = true;
+    }
+
+    std::map<const void*, unsigned int>::iterator iter = m_contexts.find(context);
+    if (iter == m_contexts.end())
+        iter = m_contexts.insert(std::make_pair(context, (unsigned int) m_contexts.size() + 1)).first;
+
+    unsigned char header[kHeaderBytes];
+    put32(header, (unsigned int) length);
+    put32(header + 4, iter->second);
+    put64(header + 8, start > m_origin ? start - m_origin : 0);
+    put32(header + 16, end - start > 0xffffffffULL ? 0xffffffffU : (unsigned int) (end - start));
+    fwrite(header, sizeof(header), 1, m_file);
+    fwrite(command, length, 1, m_file);
+    pthread_mutex_unlock(&m_lock);
+}
+
+bool readCallLog(const std::string& path, std::vector<CallRecord>& records, std::string& error)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    char magic[sizeof(kMagic)];
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 && !memcmp(magic, kMagic, sizeof(kMagic));
+    if (!ok)
+        error = path + ": not a call log";
+
+    unsigned char header[kHeaderBytes];
+    while (ok && fread(header, sizeof(header), 1, file) == 1) {
+        CallRecord record;
+        record.context = get32(header + 4);
+        record.start = get64(header + 8);
+        record.duration = get32(header + 16);
+        record.command.resize(get32(header));
+        if (!record.command.empty() && fread(&record.command[0], record.command.size(), 1, file) != 1) {
+            error = path + ": truncated call";
+            ok = false;
+            break;
+        }
+        records.push_back(record);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+} // namespace webworks
@@ -0,0 +1,72 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CALL_LOG_HPP_
+#define CALL_LOG_HPP_
+
+#include <map>
+#include <pthread.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace webworks {
+
+/**
+ * One JNEXT call as recorded by CallLogWriter.
+ */
+struct CallRecord {
+    unsigned int context;
+    unsigned long long start;
+    unsigned int duration;
+    std::string command;
+};
+
+/**
+ * Appends InvokeFunction calls to a compact binary log for later replay.
+ *
+ * The file starts with the 8 byte magic "JNXTLOG1". Every call follows as
+ * a 20 byte little-endian header (command length u32, context u32, start
+ * u64, duration u32) and the command bytes. Contexts are numbered from 1
+ * in the order they first appear; times are nanoseconds, start relative
+ * to the first call. Calls are written under a lock and flushed when the
+ * writer is deleted.
+ */
+class CallLogWriter {
+public:
+    // NULL when path is NULL or empty or the file cannot be created.
+    static CallLogWriter* open(const char* path);
+    ~CallLogWriter();
+
+    void write(const char* command, const void* context, unsigned long long start, unsigned long long end);
+
+private:
+    explicit CallLogWriter(FILE* file);
+
+    FILE* m_file;
+    pthread_mutex_t m_lock;
+    std::map<const void*, unsigned int> m_contexts;
+    unsigned long long m_origin;
+    bool m_started;
+
+    CallLogWriter(const CallLogWriter&);
+    CallLogWriter& operator=(const CallLogWriter&);
+};
+
+// Reads a whole log, false with error set if it is not one or is truncated.
+bool readCallLog(const std::string& path, std::vector<CallRecord>& records, std::string& error);
+
+} // namespace webworks
+
+#endif /* CALL_LOG_HPP_ */
@@ -0,0 +1,168 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include "command_stats.hpp"
+
+namespace webworks {
+
+static const char* kCommandNames[kCommandCount] = {
+    "getPreferredLanguage",
+    "getLocaleName",
+    "dateToString",
+    "stringToDate",
+    "getDatePattern",
+    "getDateNames",
+    "isDayLightSavingsTime",
+    "getFirstDayOfWeek",
+    "numberToString",
+    "stringToNumber",
+    "getNumberPattern",
+    "getCurrencyPattern",
+    "getCacheStats",
+    "setCacheCapacity",
+    "setTransitionWindow",
+    "getStats",
+    "resetStats",
+    "startTrace",
+    "stopTrace",
+    "dumpTrace",
+    "dateToStringBatch",
+    "numberToStringBatch",
+    "stringToNumberBatch",
+    "setResultEncoding",
+    "streamBatch"
+};
+
+const char* commandName(int command)
+{
+    return command >= 0 && command < kCommandCount ? kCommandNames[command] : "unknown";
+}
+
+CommandStats::CommandStats()
+{
+    memset(m_entries, 0, sizeof(m_entries));
+}
+
+// Values below 2^kMinBits share the first kSubBuckets linear buckets, the
+// rest get kSubBuckets buckets per power of two.
+int CommandStats::bucket(unsigned long long ticks)
+{
+    if (ticks < (1ULL << kMinBits))
+        return (int) (ticks >> (kMinBits - kSubBucketBits));
+
+    int bits = 63 - __builtin_clzll(ticks);
+    if (bits > kMaxBits)
+        return kBucketCount - 1;
+
+    int sub = (int) (ticks >> (bits - kSubBucketBits)) & (kSubBuckets - 1);
+    return (bits - kMinBits + 1) * kSubBuckets + sub;
+}
+
+// The largest value recorded into the bucket.
+unsigned long long CommandStats::bucketLimit(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return ((unsigned long long) (bucket + 1) << (kMinBits - kSubBucketBits)) - 1;
+
+    int bits = bucket / kSubBuckets - 1 + kMinBits;
+    int sub = bucket % kSubBuckets;
+    unsigned long long width = 1ULL << (bits - kSubBucketBits);
+    return (kSubBuckets + sub + 1) * width - 1;
+}
+
+void CommandStats::record(int command, unsigned long long elapsed, bool error)
+{
+    Entry& entry = m_entries[command];
+    __sync_fetch_and_add(&entry.buckets[bucket(elapsed)], 1);
+    __sync_fetch_and_add(&entry.totalTicks, elapsed);
+    if (error)
+        __sync_fetch_and_add(&entry.errors, 1);
+
+    unsigned long long max = entry.maxTicks;
+    while (elapsed > max) {
+        unsigned long long seen = __sync_val_compare_and_swap(&entry.maxTicks, max, elapsed);
+        if (seen == max)
+            break;
+        max = seen;
+    }
+}
+
+void CommandStats::reset()
+{
+    for (int command = 0; command < kCommandCount; ++command) {
+        Entry& entry = m_entries[command];
+        for (int i = 0; i < kBucketCount; ++i)
+            __sync_lock_test_and_set(&entry.buckets[i], 0);
+        __sync_lock_test_and_set(&entry.errors, 0);
+        __sync_lock_test_and_set(&entry.totalTicks, 0);
+        __sync_lock_test_and_set(&entry.maxTicks, 0);
+    }
+}
+
+// This jsoncpp has no 64-bit integers, doubles take over beyond 32 bits.
+static Json::Value toValue(unsigned long long value)
+{
+    if (value <= 0xffffffffULL)
+        return Json::Value((Json::UInt) value);
+    return Json::Value((double) value);
+}
+
+Json::Value CommandStats::toJson() const
+{
+    static const double percentiles[] = { 0.5, 0.9, 0.99 };
+    static const char* names[] = { "p50_ns", "p90_ns", "p99_ns" };
+
+    double scale = m_clock.nanosPerTick();
+    Json::Value result(Json::objectValue);
+    for (int command = 0; command < kCommandCount; ++command) {
+        const Entry& entry = m_entries[command];
+        unsigned long long count = 0;
+        for (int i = 0; i < kBucketCount; ++i)
+            count += entry.buckets[i];
+        if (!count)
+            continue;
+
+        Json::Value stats;
+        stats["count"] = toValue(count);
+        stats["errors"] = toValue(entry.errors);
+        stats["mean_ns"] = toValue((unsigned long long) (entry.totalTicks * scale / count + 0.5));
+        stats["max_ns"] = toValue((unsigned long long) (entry.maxTicks * scale + 0.5));
+
+        for (int p = 0; p < 3; ++p) {
+            unsigned long long target = (unsigned long long) (percentiles[p] * count + 0.5);
+            if (!target)
+                target = 1;
+
+            unsigned long long seen = 0;
+            int i = 0;
+            for (; i < kBucketCount - 1; ++i) {
+                seen += entry.buckets[i];
+                if (seen >= target)
+                    break;
+            }
+
+            unsigned long long limit = bucketLimit(i);
+            if (limit > entry.maxTicks)
+                limit = entry.maxTicks;
+            stats[names[p]] = toValue((unsigned long long) (limit * scale + 0.5));
+        }
+
+        result[kCommandNames[command]] = stats;
+    }
+
+    return result;
+}
+
+} // namespace webworks
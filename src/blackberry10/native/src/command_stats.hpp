@@ -0,0 +1,107 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef COMMAND_STATS_HPP_
+#define COMMAND_STATS_HPP_
+
+#include <json/value.h>
+#include "tick_clock.hpp"
+
+namespace webworks {
+
+/**
+ * Commands dispatched by GlobalizationJS::InvokeMethod.
+ */
+enum ECommand {
+    kGetPreferredLanguage,
+    kGetLocaleName,
+    kDateToString,
+    kStringToDate,
+    kGetDatePattern,
+    kGetDateNames,
+    kIsDayLightSavingsTime,
+    kGetFirstDayOfWeek,
+    kNumberToString,
+    kStringToNumber,
+    kGetNumberPattern,
+    kGetCurrencyPattern,
+    kGetCacheStats,
+    kSetCacheCapacity,
+    kSetTransitionWindow,
+    kGetStats,
+    kResetStats,
+    kStartTrace,
+    kStopTrace,
+    kDumpTrace,
+    kDateToStringBatch,
+    kNumberToStringBatch,
+    kStringToNumberBatch,
+    kSetResultEncoding,
+    kStreamBatch,
+    kCommandCount
+};
+
+const char* commandName(int command);
+
+/**
+ * Call counts, error counts and latency histograms per command.
+ *
+ * Latencies go into log-linear buckets, eight per power of two from 64
+ * ticks up, so percentiles are exact to within 12.5% like an HDR histogram
+ * with one significant digit. Recording is a couple of atomic adds and never
+ * takes a lock; reset() and toJson() may race with it and then see a call
+ * partially recorded.
+ */
+class CommandStats {
+public:
+    CommandStats();
+
+    // elapsed is the difference of two TickClock::now() readings, converted
+    // to nanoseconds by toJson().
+    void record(int command, unsigned long long elapsed, bool error);
+    void reset();
+
+    // {"dateToString":{"count":..,"errors":..,"mean_ns":..,"p50_ns":..,
+    // "p90_ns":..,"p99_ns":..,"max_ns":..},...} for commands called so far.
+    Json::Value toJson() const;
+
+    enum {
+        kSubBuckets = 8,
+        kSubBucketBits = 3,
+        kMinBits = 6,
+        kMaxBits = 40,
+        kBucketCount = (kMaxBits - kMinBits + 2) * kSubBuckets
+    };
+
+private:
+    struct Entry {
+        unsigned int buckets[kBucketCount];
+        unsigned int errors;
+        unsigned long long totalTicks;
+        unsigned long long maxTicks;
+    };
+
+    static int bucket(unsigned long long ticks);
+    static unsigned long long bucketLimit(int bucket);
+
+    TickClock m_clock;
+    Entry m_entries[kCommandCount];
+
+    CommandStats(const CommandStats&);
+    CommandStats& operator=(const CommandStats&);
+};
+
+} // namespace webworks
+
+#endif /* COMMAND_STATS_HPP_ */
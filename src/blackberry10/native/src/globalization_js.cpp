@@ -12,26 +12,186 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
 #include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include "command_stats.hpp"
 #include "globalization_js.hpp"
-#include "globalization_ndk.hpp"
+#include "globalization_engine.hpp"
+#include "probes.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
+// Formatters for the current locale are built in the background as soon as
+// the first object is created, unless the extension is built with
+// GLOBALIZATION_NO_PREWARM.
+#ifdef GLOBALIZATION_NO_PREWARM
+static const bool kPrewarm = false;
+#else
+static const bool kPrewarm = true;
+#endif
+
+// Per-command counts and latencies, left out with GLOBALIZATION_NO_STATS.
+#ifndef GLOBALIZATION_NO_STATS
+static webworks::CommandStats g_stats;
+#endif
+
+static bool isError(const std::string& result) {
+	return result.compare(0, 9, "{\"error\":") == 0;
+}
+
+static int commandId(const std::string& name) {
+	for (int id = 0; id < webworks::kCommandCount; ++id) {
+		if (name == webworks::commandName(id))
+			return id;
+	}
+	return -1;
+}
+
+// The PPS object getPreferredLanguage reads, overridable for host builds.
+#ifndef GLOBALIZATION_PPS_LOCALE_PATH
+#define GLOBALIZATION_PPS_LOCALE_PATH "/pps/services/confstr/_CS_LOCALE"
+#endif
+
+static int isspace_safe(int ch) {
+	return std::isspace(ch & 0xff);
+}
+
+static std::string& trimRight(std::string& str) {
+	str.erase(std::find_if(str.rbegin(), str.rend(), std::not1(std::ptr_fun<int, int>(isspace_safe))).base(), str.end());
+	return str;
+}
+
+static std::string readLanguageFromPPS() {
+	static const char* langfile = GLOBALIZATION_PPS_LOCALE_PATH;
+	int fd = ::open(langfile, O_RDONLY);
+	if (fd < 0) {
+		return std::string();
+	}
+
+	static const int PPS_BUFFER_READ_SIZE = 2048;
+	char buffer[PPS_BUFFER_READ_SIZE];
+	ssize_t read = ::read(fd, buffer, PPS_BUFFER_READ_SIZE - 1);
+	::close(fd);
+
+	if (read <= 0) {
+		return std::string();
+	}
+
+	std::string content(buffer, read);
+	size_t pos = content.find_first_of("::");
+
+	if (pos == std::string::npos) {
+		return std::string();
+	}
+
+	std::string lang = content.substr(pos + 2);// 2 is strlen("::");
+	return trimRight(lang);
+}
+
+// A batch command run on its own thread by streamBatch. Each chunk goes to
+// JavaScript as "<callbackId> chunk <result>" as soon as it is formatted,
+// and "<callbackId> done <summary>" follows the last one, carrying the
+// element and error counts or the error of the whole command.
+class BatchStream : public webworks::BatchSink {
+public:
+	BatchStream(GlobalizationJS* owner, webworks::GlobalizationEngine* engine, int command,
+			webworks::EResultEncoding encoding, const std::string& callbackId, size_t chunkSize,
+			const std::string& args) :
+			m_owner(owner), m_engine(engine), m_command(command), m_encoding(encoding),
+			m_callbackId(callbackId), m_chunkSize(chunkSize), m_args(args), m_stop(0), m_finished(0) {
+	}
+
+	bool start() {
+		return pthread_create(&m_thread, NULL, run, this) == 0;
+	}
+
+	void stop() {
+		__sync_lock_test_and_set(&m_stop, 1);
+	}
+
+	bool finished() {
+		return __sync_fetch_and_add(&m_finished, 0) != 0;
+	}
+
+	void join() {
+		pthread_join(m_thread, NULL);
+	}
+
+	virtual size_t chunkSize() const {
+		return m_chunkSize;
+	}
+
+	virtual bool chunk(const std::string& result) {
+		if (__sync_fetch_and_add(&m_stop, 0))
+			return false;
+		m_owner->NotifyEvent(m_callbackId + " chunk " + result);
+		return true;
+	}
+
+private:
+	static void* run(void* arg) {
+		static_cast<BatchStream*>(arg)->run();
+		return NULL;
+	}
+
+	void run() {
+		std::string summary;
+		switch (m_command) {
+		case webworks::kDateToStringBatch:
+			summary = m_engine->dateToStringBatch(m_args, m_encoding, this);
+			break;
+		case webworks::kNumberToStringBatch:
+			summary = m_engine->numberToStringBatch(m_args, m_encoding, this);
+			break;
+		default:
+			summary = m_engine->stringToNumberBatch(m_args, m_encoding, this);
+			break;
+		}
+
+		std::string().swap(m_args);
+		if (!__sync_fetch_and_add(&m_stop, 0))
+			m_owner->NotifyEvent(m_callbackId + " done " + summary);
+		__sync_lock_test_and_set(&m_finished, 1);
+	}
+
+	GlobalizationJS* m_owner;
+	webworks::GlobalizationEngine* m_engine;
+	int m_command;
+	webworks::EResultEncoding m_encoding;
+	std::string m_callbackId;
+	size_t m_chunkSize;
+	std::string m_args;
+	pthread_t m_thread;
+	volatile int m_stop;
+	volatile int m_finished;
+};
+
 /**
  * Default constructor.
  */
 GlobalizationJS::GlobalizationJS(const std::string& id) :
-		m_id(id) {
-	m_pGlobalizationController = new webworks::GlobalizationNDK(this);
+		m_id(id), m_encoding(webworks::kEncodingJson) {
+	pthread_mutex_init(&m_streamLock, NULL);
+	m_pGlobalizationController = webworks::GlobalizationEngine::acquire(kPrewarm);
 }
 
 /**
  * GlobalizationJS destructor.
  */
 GlobalizationJS::~GlobalizationJS() {
+	joinStreams(true);
+	pthread_mutex_destroy(&m_streamLock);
+
 	if (m_pGlobalizationController)
-		delete m_pGlobalizationController;
+		webworks::GlobalizationEngine::release(m_pGlobalizationController);
 }
 
 /**
@@ -74,38 +234,252 @@ string GlobalizationJS::InvokeMethod(const string& command) {
 	std::string strCommand = command.substr(0, commandIndex);
 	size_t callbackIndex = command.find_first_of(" ", commandIndex + 1);
 	std::string callbackId = command.substr(commandIndex + 1, callbackIndex - commandIndex - 1);
-	std::string arg = command.substr(callbackIndex + 1, command.length());
-
-	// based on the command given, run the appropriate method in globalizationndk.cpp
-    if (strCommand == "getPreferredLanguage") {
-        return m_pGlobalizationController->getPreferredLanguage();
-    } else if (strCommand == "getLocaleName") {
-        return m_pGlobalizationController->getLocaleName();
-    } else if (strCommand == "dateToString") {
-        return m_pGlobalizationController->dateToString(arg);
-    } else if (strCommand == "stringToDate") {
-        return m_pGlobalizationController->stringToDate(arg);
-    } else if (strCommand == "getDatePattern") {
-        return m_pGlobalizationController->getDatePattern(arg);
-    } else if (strCommand == "getDateNames") {
-        return m_pGlobalizationController->getDateNames(arg);
-    } else if (strCommand == "isDayLightSavingsTime") {
-        return m_pGlobalizationController->isDayLightSavingsTime(arg);
-    } else if (strCommand == "getFirstDayOfWeek") {
-        return m_pGlobalizationController->getFirstDayOfWeek();
-    } else if (strCommand == "numberToString") {
-        return m_pGlobalizationController->numberToString(arg);
-    } else if (strCommand == "stringToNumber") {
-        return m_pGlobalizationController->stringToNumber(arg);
-    } else if (strCommand == "getNumberPattern") {
-        return m_pGlobalizationController->getNumberPattern(arg);
-    } else if (strCommand == "getCurrencyPattern") {
-        return m_pGlobalizationController->getCurrencyPattern(arg);
-	}
-
-	strCommand.append(";");
-	strCommand.append(command);
-	return strCommand;
+	std::string arg = callbackIndex == string::npos ? std::string() : command.substr(callbackIndex + 1);
+
+	int id = commandId(strCommand);
+	if (id < 0) {
+		strCommand.append(";");
+		strCommand.append(command);
+		return strCommand;
+	}
+
+	webworks::TraceSpan span("dispatch", "command", webworks::commandName(id));
+	GLOBALIZATION_PROBE(command__entry, id, arg.size(), 0);
+#ifndef GLOBALIZATION_NO_STATS
+	unsigned long long start = webworks::TickClock::now();
+#endif
+
+	std::string result = dispatch(id, callbackId, arg);
+
+#ifndef GLOBALIZATION_NO_STATS
+	g_stats.record(id, webworks::TickClock::now() - start, isError(result));
+#endif
+	GLOBALIZATION_PROBE(command__return, id, result.size(), isError(result));
+	return result;
+}
+
+// based on the command given, run the appropriate method in the shared GlobalizationEngine
+string GlobalizationJS::dispatch(int command, const string& callbackId, const string& arg) {
+	switch (command) {
+	case webworks::kGetPreferredLanguage:
+		return m_pGlobalizationController->getPreferredLanguage(arg, readLanguageFromPPS());
+	case webworks::kGetLocaleName:
+		return m_pGlobalizationController->getLocaleName(arg);
+	case webworks::kDateToString:
+		return m_pGlobalizationController->dateToString(arg);
+	case webworks::kStringToDate:
+		return m_pGlobalizationController->stringToDate(arg);
+	case webworks::kGetDatePattern:
+		return m_pGlobalizationController->getDatePattern(arg);
+	case webworks::kGetDateNames:
+		return m_pGlobalizationController->getDateNames(arg);
+	case webworks::kIsDayLightSavingsTime:
+		return m_pGlobalizationController->isDayLightSavingsTime(arg);
+	case webworks::kGetFirstDayOfWeek:
+		return m_pGlobalizationController->getFirstDayOfWeek(arg);
+	case webworks::kNumberToString:
+		return m_pGlobalizationController->numberToString(arg);
+	case webworks::kStringToNumber:
+		return m_pGlobalizationController->stringToNumber(arg);
+	case webworks::kGetNumberPattern:
+		return m_pGlobalizationController->getNumberPattern(arg);
+	case webworks::kGetCurrencyPattern:
+		return m_pGlobalizationController->getCurrencyPattern(arg);
+	case webworks::kGetCacheStats:
+		return m_pGlobalizationController->getCacheStats();
+	case webworks::kSetCacheCapacity:
+		return m_pGlobalizationController->setCacheCapacity(arg);
+	case webworks::kSetTransitionWindow:
+		return m_pGlobalizationController->setTransitionWindow(arg);
+	case webworks::kGetStats:
+		return getStats();
+	case webworks::kResetStats:
+		return resetStats();
+	case webworks::kStartTrace:
+		return startTrace();
+	case webworks::kStopTrace:
+		return stopTrace();
+	case webworks::kDumpTrace:
+		return dumpTrace(arg);
+	case webworks::kDateToStringBatch:
+		return m_pGlobalizationController->dateToStringBatch(arg, m_encoding);
+	case webworks::kNumberToStringBatch:
+		return m_pGlobalizationController->numberToStringBatch(arg, m_encoding);
+	case webworks::kStringToNumberBatch:
+		return m_pGlobalizationController->stringToNumberBatch(arg, m_encoding);
+	case webworks::kSetResultEncoding:
+		return setResultEncoding(arg);
+	case webworks::kStreamBatch:
+		return streamBatch(callbackId, arg);
+	default:
+		return std::string();
+	}
+}
+
+// Per-command statistics are shared by all Globalization objects.
+string GlobalizationJS::getStats() {
+	Json::Value root;
+#ifdef GLOBALIZATION_NO_STATS
+	Json::Value error;
+	error["code"] = 0;
+	error["message"] = "Statistics are not compiled in!";
+	root["error"] = error;
+#else
+	root["result"] = g_stats.toJson();
+#endif
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+string GlobalizationJS::resetStats() {
+#ifndef GLOBALIZATION_NO_STATS
+	g_stats.reset();
+#endif
+
+	Json::Value root;
+	root["result"] = true;
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+// Tracing is process-wide as well; dumpTrace writes Chrome trace_event JSON.
+string GlobalizationJS::startTrace() {
+	webworks::Trace::start();
+
+	Json::Value root;
+	root["result"] = true;
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+string GlobalizationJS::stopTrace() {
+	webworks::Trace::stop();
+
+	Json::Value root;
+	root["result"] = true;
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+string GlobalizationJS::dumpTrace(const string& arg) {
+	Json::Reader reader;
+	Json::Value args;
+	Json::Value root;
+	std::string error;
+
+	if (!reader.parse(arg, args) || !args["path"].isString() || args["path"].asString().empty()) {
+		error = "No path provided!";
+	} else {
+		int events = webworks::Trace::dump(args["path"].asString(), error);
+		if (events >= 0)
+			root["result"] = events;
+	}
+
+	if (!error.empty()) {
+		Json::Value value;
+		value["code"] = 0;
+		value["message"] = error;
+		root["error"] = value;
+	}
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+// index.js asks for the compact encoding once per object; an extension
+// that predates it answers with an unknown command and JSON stays in use.
+string GlobalizationJS::setResultEncoding(const string& arg) {
+	Json::Reader reader;
+	Json::Value args;
+	Json::Value root;
+
+	std::string encoding;
+	if (reader.parse(arg, args) && args["encoding"].isString())
+		encoding = args["encoding"].asString();
+
+	if (encoding == "json" || encoding == "compact") {
+		m_encoding = encoding == "json" ? webworks::kEncodingJson : webworks::kEncodingCompact;
+		root["result"] = encoding;
+	} else {
+		Json::Value error;
+		error["code"] = 0;
+		error["message"] = "Unsupported encoding!";
+		root["error"] = error;
+	}
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+// "<batch command> <chunk size> <json>": starts the batch command on its own
+// thread and returns at once, its results follow as events. Only one chunk
+// of results is held in memory at a time.
+string GlobalizationJS::streamBatch(const string& callbackId, const string& arg) {
+	size_t commandEnd = arg.find(' ');
+	size_t sizeEnd = commandEnd == string::npos ? string::npos : arg.find(' ', commandEnd + 1);
+	int command = commandId(arg.substr(0, commandEnd));
+	long chunkSize = sizeEnd == string::npos ? 0 : strtol(arg.c_str() + commandEnd + 1, NULL, 10);
+
+	std::string error;
+	if (command != webworks::kDateToStringBatch && command != webworks::kNumberToStringBatch
+			&& command != webworks::kStringToNumberBatch) {
+		error = "Unsupported batch command!";
+	} else if (chunkSize < 1) {
+		error = "Invalid chunkSize!";
+	} else {
+		joinStreams(false);
+
+		BatchStream* stream = new BatchStream(this, m_pGlobalizationController, command, m_encoding,
+				callbackId, chunkSize, arg.substr(sizeEnd + 1));
+		pthread_mutex_lock(&m_streamLock);
+		if (stream->start()) {
+			m_streams.push_back(stream);
+		} else {
+			delete stream;
+			error = "Unable to start the stream!";
+		}
+		pthread_mutex_unlock(&m_streamLock);
+	}
+
+	Json::Value root;
+	if (error.empty()) {
+		root["result"] = true;
+	} else {
+		Json::Value value;
+		value["code"] = 0;
+		value["message"] = error;
+		root["error"] = value;
+	}
+
+	Json::FastWriter writer;
+	return writer.write(root);
+}
+
+// Joins the streams that have finished, or stops and joins all of them.
+void GlobalizationJS::joinStreams(bool all) {
+	std::list<BatchStream*> done;
+
+	pthread_mutex_lock(&m_streamLock);
+	for (std::list<BatchStream*>::iterator it = m_streams.begin(); it != m_streams.end();) {
+		if (all || (*it)->finished()) {
+			if (all)
+				(*it)->stop();
+			done.push_back(*it);
+			it = m_streams.erase(it);
+		} else {
+			++it;
+		}
+	}
+	pthread_mutex_unlock(&m_streamLock);
+
+	for (std::list<BatchStream*>::iterator it = done.begin(); it != done.end(); ++it) {
+		(*it)->join();
+		delete *it;
+	}
 }
 
 // Notifies JavaScript of an event
@@ -15,9 +15,13 @@
 #ifndef GlobalizationJS_HPP_
 #define GlobalizationJS_HPP_
 
+#include <list>
+#include <pthread.h>
 #include <string>
 #include "../public/plugin.h"
-#include "globalization_ndk.hpp"
+#include "globalization_engine.hpp"
+
+class BatchStream;
 
 class GlobalizationJS: public JSExt {
 
@@ -29,9 +33,24 @@ public:
     void NotifyEvent(const std::string& event);
 
 private:
+    std::string dispatch(int command, const std::string& callbackId, const std::string& arg);
+    std::string getStats();
+    std::string resetStats();
+    std::string startTrace();
+    std::string stopTrace();
+    std::string dumpTrace(const std::string& arg);
+    std::string setResultEncoding(const std::string& arg);
+    std::string streamBatch(const std::string& callbackId, const std::string& arg);
+    void joinStreams(bool all);
+
     std::string m_id;
-    // Definition of a pointer to the actual native extension code
-    webworks::GlobalizationNDK *m_pGlobalizationController;
+    // How this object returns batch results, see setResultEncoding.
+    webworks::EResultEncoding m_encoding;
+    // Streamed batch commands, running or finished and not joined yet.
+    pthread_mutex_t m_streamLock;
+    std::list<BatchStream*> m_streams;
+    // The process-wide engine, shared with every other Globalization object
+    webworks::GlobalizationEngine *m_pGlobalizationController;
 };
 
 #endif /* GlobalizationJS_HPP_ */
@@ -0,0 +1,189 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include "compact_encoding.hpp"
+
+namespace webworks {
+
+static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void CompactWriter::putUInt32(unsigned value)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; ++i)
+        bytes[i] = (char) (value >> (8 * i));
+    m_bytes.append(bytes, 4);
+}
+
+void CompactWriter::putDouble(double value)
+{
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    char bytes[8];
+    for (int i = 0; i < 8; ++i)
+        bytes[i] = (char) (bits >> (8 * i));
+    m_bytes.append(bytes, 8);
+}
+
+void CompactWriter::putString(const std::string& value)
+{
+    putUInt32((unsigned) value.size());
+    m_bytes.append(value);
+}
+
+bool CompactReader::getByte(unsigned char& value)
+{
+    if (m_bytes.size() - m_offset < 1)
+        return false;
+    value = (unsigned char) m_bytes[m_offset++];
+    return true;
+}
+
+bool CompactReader::getUInt32(unsigned& value)
+{
+    if (m_bytes.size() - m_offset < 4)
+        return false;
+
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= (unsigned) (unsigned char) m_bytes[m_offset + i] << (8 * i);
+    m_offset += 4;
+    return true;
+}
+
+bool CompactReader::getDouble(double& value)
+{
+    if (m_bytes.size() - m_offset < 8)
+        return false;
+
+    unsigned long long bits = 0;
+    for (int i = 0; i < 8; ++i)
+        bits |= (unsigned long long) (unsigned char) m_bytes[m_offset + i] << (8 * i);
+    memcpy(&value, &bits, sizeof(value));
+    m_offset += 8;
+    return true;
+}
+
+bool CompactReader::getString(std::string& value)
+{
+    unsigned length;
+    if (!getUInt32(length) || m_bytes.size() - m_offset < length)
+        return false;
+
+    value.assign(m_bytes, m_offset, length);
+    m_offset += length;
+    return true;
+}
+
+std::string base64Encode(const std::string& bytes)
+{
+    std::string text;
+    text.reserve((bytes.size() + 2) / 3 * 4);
+
+    const unsigned char* in = (const unsigned char*) bytes.data();
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        unsigned group = in[i] << 16 | in[i + 1] << 8 | in[i + 2];
+        text.push_back(kAlphabet[group >> 18]);
+        text.push_back(kAlphabet[group >> 12 & 63]);
+        text.push_back(kAlphabet[group >> 6 & 63]);
+        text.push_back(kAlphabet[group & 63]);
+    }
+
+    if (i < bytes.size()) {
+        unsigned group = in[i] << 16;
+        if (i + 1 < bytes.size())
+            group |= in[i + 1] << 8;
+        text.push_back(kAlphabet[group >> 18]);
+        text.push_back(kAlphabet[group >> 12 & 63]);
+        text.push_back(i + 1 < bytes.size() ? kAlphabet[group >> 6 & 63] : '=');
+        text.push_back('=');
+    }
+
+    return text;
+}
+
+// Sextet of every input byte, 0xff for bytes outside the alphabet.
+static unsigned char kSextets[256];
+
+static bool initSextets()
+{
+    memset(kSextets, 0xff, sizeof(kSextets));
+    for (int i = 0; i < 64; ++i)
+        kSextets[(unsigned char) kAlphabet[i]] = (unsigned char) i;
+    return true;
+}
+
+static const bool kSextetsReady = initSextets();
+
+// Four characters become three bytes per step, with one check for the
+// whole group; only the final group can carry padding.
+bool base64Decode(const char* text, size_t length, char* bytes, size_t& decoded)
+{
+    (void) kSextetsReady;
+    decoded = 0;
+    if (length % 4)
+        return false;
+    if (!length)
+        return true;
+
+    const unsigned char* in = (const unsigned char*) text;
+    const unsigned char* last = in + length - 4;
+    unsigned char* out = (unsigned char*) bytes;
+
+    for (; in < last; in += 4, out += 3) {
+        unsigned a = kSextets[in[0]], b = kSextets[in[1]], c = kSextets[in[2]], d = kSextets[in[3]];
+        if ((a | b | c | d) & 0x80)
+            return false;
+
+        unsigned group = a << 18 | b << 12 | c << 6 | d;
+        out[0] = (unsigned char) (group >> 16);
+        out[1] = (unsigned char) (group >> 8);
+        out[2] = (unsigned char) group;
+    }
+
+    int padding = in[3] != '=' ? 0 : in[2] != '=' ? 1 : 2;
+    unsigned a = kSextets[in[0]], b = kSextets[in[1]];
+    unsigned c = padding > 1 ? 0 : kSextets[in[2]];
+    unsigned d = padding ? 0 : kSextets[in[3]];
+    if ((a | b | c | d) & 0x80)
+        return false;
+
+    unsigned group = a << 18 | b << 12 | c << 6 | d;
+    out[0] = (unsigned char) (group >> 16);
+    if (padding < 2)
+        out[1] = (unsigned char) (group >> 8);
+    if (padding < 1)
+        out[2] = (unsigned char) group;
+
+    decoded = out - (unsigned char*) bytes + 3 - padding;
+    return true;
+}
+
+bool base64Decode(const std::string& text, std::string& bytes)
+{
+    bytes.resize(base64DecodedSize(text.size()));
+    size_t decoded;
+    if (!base64Decode(text.data(), text.size(), bytes.empty() ? NULL : &bytes[0], decoded)) {
+        bytes.clear();
+        return false;
+    }
+
+    bytes.resize(decoded);
+    return true;
+}
+
+} // namespace webworks
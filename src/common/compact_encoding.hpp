@@ -0,0 +1,89 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPACT_ENCODING_HPP_
+#define COMPACT_ENCODING_HPP_
+
+#include <string>
+
+namespace webworks {
+
+// How a Globalization object returns batch results, chosen by index.js with
+// setResultEncoding. Errors of the whole command are always JSON, so a
+// reply starting with '{' is JSON under either encoding.
+enum EResultEncoding {
+    kEncodingJson,
+    kEncodingCompact
+};
+
+// Compact results are base64 of little-endian binary:
+//
+//   batch   := u32 count, element * count, u32 errors, error * errors
+//   element := u8 0                      null, the element failed
+//            | u8 1, f64 value
+//            | u8 2, string
+//   error   := u32 index, u8 code, string message
+//   string  := u32 length, UTF-8 bytes
+enum ECompactTag {
+    kCompactNull,
+    kCompactNumber,
+    kCompactString
+};
+
+class CompactWriter {
+public:
+    void putByte(unsigned char value) { m_bytes.push_back((char) value); }
+    void putUInt32(unsigned value);
+    void putDouble(double value);
+    void putString(const std::string& value);
+
+    void append(const CompactWriter& other) { m_bytes.append(other.m_bytes); }
+    const std::string& bytes() const { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+// Reads what CompactWriter wrote; every get fails once the input runs out.
+class CompactReader {
+public:
+    explicit CompactReader(const std::string& bytes) : m_bytes(bytes), m_offset(0) {}
+
+    bool getByte(unsigned char& value);
+    bool getUInt32(unsigned& value);
+    bool getDouble(double& value);
+    bool getString(std::string& value);
+
+    bool atEnd() const { return m_offset == m_bytes.size(); }
+
+private:
+    const std::string& m_bytes;
+    size_t m_offset;
+};
+
+// Standard alphabet with padding. base64Decode fails on anything else.
+std::string base64Encode(const std::string& bytes);
+bool base64Decode(const std::string& text, std::string& bytes);
+
+// Decodes into a buffer of at least base64DecodedSize(length) bytes.
+bool base64Decode(const char* text, size_t length, char* bytes, size_t& decoded);
+
+inline size_t base64DecodedSize(size_t length)
+{
+    return length / 4 * 3;
+}
+
+} // namespace webworks
+
+#endif /* COMPACT_ENCODING_HPP_ */
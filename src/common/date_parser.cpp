@@ -0,0 +1,537 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <string>
+#include <unicode/dtfmtsym.h>
+#include <unicode/gregocal.h>
+#include <unicode/smpdtfmt.h>
+#include "date_parser.hpp"
+
+namespace webworks {
+
+// Digit runs longer than this can not be a valid field and are left to ICU.
+static const int kMaxDigits = 9;
+
+NameTrie::NameTrie()
+{
+    Node root;
+    root.value = -1;
+    m_nodes.push_back(root);
+}
+
+void NameTrie::add(const std::string& utf8, int value)
+{
+    if (utf8.empty())
+        return;
+
+    int node = 0;
+    for (size_t i = 0; i < utf8.size(); ++i) {
+        unsigned char byte = utf8[i];
+        int next = -1;
+        const std::vector<Edge>& edges = m_nodes[node].edges;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            if (edges[e].byte == byte) {
+                next = edges[e].target;
+                break;
+            }
+        }
+
+        if (next < 0) {
+            Node child;
+            child.value = -1;
+            m_nodes.push_back(child);
+            next = m_nodes.size() - 1;
+
+            Edge edge;
+            edge.byte = byte;
+            edge.target = next;
+            m_nodes[node].edges.push_back(edge);
+        }
+        node = next;
+    }
+
+    // Keep the first value registered for a name, like ICU does.
+    if (m_nodes[node].value < 0)
+        m_nodes[node].value = value;
+}
+
+size_t NameTrie::match(const char* begin, const char* end, int& value) const
+{
+    size_t matched = 0;
+    int node = 0;
+    for (const char* p = begin; p < end; ++p) {
+        unsigned char byte = *p;
+        const std::vector<Edge>& edges = m_nodes[node].edges;
+        int next = -1;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            if (edges[e].byte == byte) {
+                next = edges[e].target;
+                break;
+            }
+        }
+
+        if (next < 0)
+            break;
+
+        node = next;
+        if (m_nodes[node].value >= 0) {
+            value = m_nodes[node].value;
+            matched = p - begin + 1;
+        }
+    }
+
+    return matched;
+}
+
+static void addNames(NameTrie& trie, const UnicodeString* names, int32_t count, int32_t first)
+{
+    for (int32_t i = first; i < count; ++i) {
+        std::string utf8;
+        names[i].toUTF8String(utf8);
+        trie.add(utf8, i);
+    }
+}
+
+static bool isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int daysInMonth(int year, int month)
+{
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 1 && isLeapYear(year))
+        return 29;
+    return days[month];
+}
+
+CompiledDateParser::CompiledDateParser(DateFormat* df)
+    : m_format(df)
+    , m_calendar(NULL)
+    , m_centuryStartYear(0)
+{
+    if (!m_format || m_format->getDynamicClassID() != SimpleDateFormat::getStaticClassID())
+        return;
+
+    const Calendar* cal = m_format->getCalendar();
+    if (!cal || cal->getDynamicClassID() != GregorianCalendar::getStaticClassID())
+        return;
+
+    m_calendar = cal->clone();
+    if (!m_calendar)
+        return;
+
+    SimpleDateFormat* sdf = (SimpleDateFormat*) m_format;
+
+    UErrorCode status = U_ZERO_ERROR;
+    m_calendar->setTime(sdf->get2DigitYearStart(status), status);
+    m_centuryStartYear = m_calendar->get(UCAL_YEAR, status);
+    if (U_FAILURE(status))
+        return;
+
+    const DateFormatSymbols* dfs = sdf->getDateFormatSymbols();
+    if (!dfs)
+        return;
+
+    int32_t count = 0;
+    const UnicodeString* names = dfs->getMonths(count, DateFormatSymbols::FORMAT, DateFormatSymbols::WIDE);
+    addNames(m_wideMonths, names, count, 0);
+    names = dfs->getMonths(count, DateFormatSymbols::FORMAT, DateFormatSymbols::ABBREVIATED);
+    addNames(m_shortMonths, names, count, 0);
+    // Weekday arrays are indexed by UCAL_SUNDAY..UCAL_SATURDAY, slot 0 is unused.
+    names = dfs->getWeekdays(count, DateFormatSymbols::FORMAT, DateFormatSymbols::WIDE);
+    addNames(m_wideWeekdays, names, count, 1);
+    names = dfs->getWeekdays(count, DateFormatSymbols::FORMAT, DateFormatSymbols::ABBREVIATED);
+    addNames(m_shortWeekdays, names, count, 1);
+    names = dfs->getAmPmStrings(count);
+    addNames(m_ampm, names, count, 0);
+
+    UnicodeString pattern;
+    sdf->toPattern(pattern);
+    if (!compile(pattern))
+        m_steps.clear();
+}
+
+CompiledDateParser::~CompiledDateParser()
+{
+    delete m_calendar;
+    delete m_format;
+}
+
+bool CompiledDateParser::isNumeric(EField field)
+{
+    switch (field) {
+    case kYear:
+    case kMonth:
+    case kDay:
+    case kHour0To23:
+    case kHour1To24:
+    case kHour0To11:
+    case kHour1To12:
+    case kMinute:
+    case kSecond:
+    case kFraction:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CompiledDateParser::compile(const UnicodeString& pattern)
+{
+    bool hasAmPm = false, has24Hour = false, hasField = false;
+    std::string literal;
+    int32_t len = pattern.length();
+
+    for (int32_t i = 0; i < len; ) {
+        UChar32 ch = pattern.char32At(i);
+
+        if (ch == 0x27) {
+            // Quoted literal text, where '' stands for a single quote.
+            if (i + 1 < len && pattern.charAt(i + 1) == 0x27) {
+                literal += '\'';
+                i += 2;
+                continue;
+            }
+
+            int32_t j = i + 1;
+            for (; j < len; ++j) {
+                if (pattern.charAt(j) != 0x27)
+                    continue;
+                if (j + 1 < len && pattern.charAt(j + 1) == 0x27) {
+                    ++j;
+                    continue;
+                }
+                break;
+            }
+            UnicodeString quoted;
+            pattern.extractBetween(i + 1, j, quoted);
+            quoted.findAndReplace(UnicodeString("''", -1, US_INV), UnicodeString("'", -1, US_INV));
+            quoted.toUTF8String(literal);
+            i = j + 1;
+            continue;
+        }
+
+        if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+            int32_t count = 1;
+            while (i + count < len && pattern.charAt(i + count) == ch)
+                ++count;
+
+            if (!literal.empty()) {
+                Step step;
+                step.field = kLiteral;
+                step.count = 0;
+                step.literal = literal;
+                m_steps.push_back(step);
+                literal.clear();
+            }
+
+            Step step;
+            step.count = count;
+            switch (ch) {
+            case 'y':
+                step.field = kYear;
+                break;
+            case 'M':
+                if (count <= 2)
+                    step.field = kMonth;
+                else if (count <= 4)
+                    step.field = kMonthName;
+                else
+                    return false;
+                break;
+            case 'E':
+                if (count > 4)
+                    return false;
+                step.field = kWeekdayName;
+                break;
+            case 'd':
+                step.field = kDay;
+                break;
+            case 'H':
+                step.field = kHour0To23;
+                has24Hour = true;
+                break;
+            case 'k':
+                step.field = kHour1To24;
+                has24Hour = true;
+                break;
+            case 'K':
+                step.field = kHour0To11;
+                break;
+            case 'h':
+                step.field = kHour1To12;
+                break;
+            case 'm':
+                step.field = kMinute;
+                break;
+            case 's':
+                step.field = kSecond;
+                break;
+            case 'S':
+                step.field = kFraction;
+                break;
+            case 'a':
+                step.field = kAmPm;
+                hasAmPm = true;
+                break;
+            default:
+                // Eras, zones, week fields, stand-alone forms... are left to ICU.
+                return false;
+            }
+
+            // Abutting numeric fields need ICU's digit counting rules.
+            if (isNumeric(step.field) && !m_steps.empty() && isNumeric(m_steps.back().field))
+                return false;
+
+            m_steps.push_back(step);
+            hasField = true;
+            i += count;
+            continue;
+        }
+
+        UnicodeString(ch).toUTF8String(literal);
+        i += U16_LENGTH(ch);
+    }
+
+    if (!literal.empty()) {
+        Step step;
+        step.field = kLiteral;
+        step.count = 0;
+        step.literal = literal;
+        m_steps.push_back(step);
+    }
+
+    if (hasAmPm && has24Hour)
+        return false;
+
+    if (hasAmPm && m_ampm.empty())
+        return false;
+
+    return hasField;
+}
+
+bool CompiledDateParser::match(const std::string& utf8, DateFields& fields)
+{
+    if (m_steps.empty())
+        return false;
+
+    const char* p = utf8.data();
+    const char* end = p + utf8.size();
+
+    int year = -1, month = -1, day = -1, weekday = -1;
+    int hourOfDay = -1, hour = -1, ampm = -1;
+    int minute = -1, second = -1, millisecond = -1;
+
+    for (size_t s = 0; s < m_steps.size(); ++s) {
+        const Step& step = m_steps[s];
+
+        if (step.field == kLiteral) {
+            size_t n = step.literal.size();
+            if ((size_t) (end - p) < n || memcmp(p, step.literal.data(), n))
+                return false;
+            p += n;
+            continue;
+        }
+
+        if (step.field == kMonthName || step.field == kWeekdayName || step.field == kAmPm) {
+            // Wide names are tried before abbreviated ones, in ICU's order.
+            int value = -1;
+            size_t n;
+            if (step.field == kMonthName) {
+                n = m_wideMonths.match(p, end, value);
+                if (!n)
+                    n = m_shortMonths.match(p, end, value);
+                month = value;
+            } else if (step.field == kWeekdayName) {
+                n = m_wideWeekdays.match(p, end, value);
+                if (!n)
+                    n = m_shortWeekdays.match(p, end, value);
+                weekday = value;
+            } else {
+                n = m_ampm.match(p, end, value);
+                ampm = value;
+            }
+
+            if (!n)
+                return false;
+            p += n;
+            continue;
+        }
+
+        const char* start = p;
+        int value = 0;
+        while (p < end && *p >= '0' && *p <= '9' && p - start < kMaxDigits) {
+            value = value * 10 + (*p - '0');
+            ++p;
+        }
+
+        int digits = p - start;
+        if (!digits || (p < end && *p >= '0' && *p <= '9'))
+            return false;
+
+        switch (step.field) {
+        case kYear:
+            if (step.count < 3 && digits == 2) {
+                // Place two digit years in the century starting at the
+                // formatter's default century, exactly like ICU does.
+                int ambiguous = m_centuryStartYear % 100;
+                if (value == ambiguous)
+                    return false;
+                value += (m_centuryStartYear / 100) * 100 + (value < ambiguous ? 100 : 0);
+            }
+            year = value;
+            break;
+        case kMonth:
+            if (value < 1 || value > 12)
+                return false;
+            month = value - 1;
+            break;
+        case kDay:
+            day = value;
+            break;
+        case kHour0To23:
+            if (value > 23)
+                return false;
+            hourOfDay = value;
+            break;
+        case kHour1To24:
+            if (value < 1 || value > 24)
+                return false;
+            hourOfDay = value == 24 ? 0 : value;
+            break;
+        case kHour0To11:
+            if (value > 11)
+                return false;
+            hour = value;
+            break;
+        case kHour1To12:
+            if (value < 1 || value > 12)
+                return false;
+            hour = value == 12 ? 0 : value;
+            break;
+        case kMinute:
+            if (value > 59)
+                return false;
+            minute = value;
+            break;
+        case kSecond:
+            if (value > 59)
+                return false;
+            second = value;
+            break;
+        case kFraction:
+            for (; digits < 3; ++digits)
+                value *= 10;
+            for (; digits > 3; --digits)
+                value /= 10;
+            millisecond = value;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    if (p != end)
+        return false;
+
+    // Out of range values would be rolled over by the lenient calendar, and
+    // years before the Gregorian cutover follow the Julian calendar.
+    if (year >= 0 && (year < 1583 || year > 9999))
+        return false;
+
+    if (day >= 0 && (day < 1 || day > daysInMonth(year >= 0 ? year : 1970, month >= 0 ? month : 0)))
+        return false;
+
+    // Set the same fields ICU sets on its cleared calendar clone.
+    m_calendar->clear();
+    if (year >= 0)
+        m_calendar->set(UCAL_YEAR, year);
+    if (month >= 0)
+        m_calendar->set(UCAL_MONTH, month);
+    if (day >= 0)
+        m_calendar->set(UCAL_DATE, day);
+    if (hourOfDay >= 0)
+        m_calendar->set(UCAL_HOUR_OF_DAY, hourOfDay);
+    if (hour >= 0)
+        m_calendar->set(UCAL_HOUR, hour);
+    if (ampm >= 0)
+        m_calendar->set(UCAL_AM_PM, ampm);
+    if (minute >= 0)
+        m_calendar->set(UCAL_MINUTE, minute);
+    if (second >= 0)
+        m_calendar->set(UCAL_SECOND, second);
+    if (millisecond >= 0)
+        m_calendar->set(UCAL_MILLISECOND, millisecond);
+
+    UErrorCode status = U_ZERO_ERROR;
+    m_calendar->getTime(status);
+    if (U_FAILURE(status))
+        return false;
+
+    // A weekday that disagrees with the date is for ICU to sort out.
+    if (weekday >= 0 && m_calendar->get(UCAL_DAY_OF_WEEK, status) != weekday)
+        return false;
+
+    readFields(fields);
+    return true;
+}
+
+bool CompiledDateParser::parseWithICU(const std::string& utf8, DateFields& fields)
+{
+    UnicodeString uDate = UnicodeString::fromUTF8(utf8);
+    UErrorCode status = U_ZERO_ERROR;
+    UDate date = m_format->parse(uDate, status);
+
+    // Note: not sure why U_ERROR_WARNING_START is returned when parse succeeded.
+    if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START)
+        return false;
+
+    if (!m_calendar) {
+        m_calendar = Calendar::createInstance(status);
+        if (!m_calendar)
+            return false;
+    }
+
+    status = U_ZERO_ERROR;
+    m_calendar->setTime(date, status);
+    if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START)
+        return false;
+
+    readFields(fields);
+    return true;
+}
+
+void CompiledDateParser::readFields(DateFields& fields)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    fields.year = m_calendar->get(UCAL_YEAR, status);
+    fields.month = m_calendar->get(UCAL_MONTH, status);
+    fields.day = m_calendar->get(UCAL_DAY_OF_MONTH, status);
+    fields.hour = m_calendar->get(UCAL_HOUR_OF_DAY, status);
+    fields.minute = m_calendar->get(UCAL_MINUTE, status);
+    fields.second = m_calendar->get(UCAL_SECOND, status);
+    fields.millisecond = m_calendar->get(UCAL_MILLISECOND, status);
+}
+
+bool CompiledDateParser::parse(const std::string& utf8, DateFields& fields)
+{
+    if (match(utf8, fields))
+        return true;
+
+    return parseWithICU(utf8, fields);
+}
+
+} // namespace webworks
@@ -0,0 +1,136 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef DATE_PARSER_HPP_
+#define DATE_PARSER_HPP_
+
+#include <string>
+#include <vector>
+#include <unicode/calendar.h>
+#include <unicode/datefmt.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+/**
+ * Calendar fields reported back to JavaScript by stringToDate.
+ */
+struct DateFields {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+    int millisecond;
+};
+
+/**
+ * Byte-level trie of localized names (months, weekdays, AM/PM markers).
+ * match() returns the longest name that prefixes the input, which is how
+ * ICU resolves ambiguous names as well.
+ */
+class NameTrie {
+public:
+    NameTrie();
+
+    void add(const std::string& utf8, int value);
+    bool empty() const { return m_nodes.size() == 1; }
+    size_t match(const char* begin, const char* end, int& value) const;
+
+private:
+    struct Edge {
+        unsigned char byte;
+        int target;
+    };
+
+    struct Node {
+        int value;
+        std::vector<Edge> edges;
+    };
+
+    std::vector<Node> m_nodes;
+};
+
+/**
+ * Deterministic parser compiled from the pattern of a SimpleDateFormat.
+ *
+ * The pattern is turned into a flat list of steps (literal text, digit runs
+ * and name tries) that is matched against the UTF-8 input in a single pass.
+ * Whenever the input does not follow the pattern exactly, or the pattern
+ * uses fields the matcher does not understand, the ICU lenient parser of
+ * the wrapped DateFormat is used instead, so results never differ from it.
+ */
+class CompiledDateParser {
+public:
+    // Takes ownership of the DateFormat.
+    explicit CompiledDateParser(DateFormat* df);
+    ~CompiledDateParser();
+
+    bool parse(const std::string& utf8, DateFields& fields);
+
+    // Runs the compiled matcher only, false means the input needs ICU.
+    bool match(const std::string& utf8, DateFields& fields);
+
+    bool isCompiled() const { return !m_steps.empty(); }
+    DateFormat* format() const { return m_format; }
+
+private:
+    enum EField {
+        kLiteral,
+        kYear,
+        kMonth,
+        kMonthName,
+        kWeekdayName,
+        kDay,
+        kHour0To23,
+        kHour1To24,
+        kHour0To11,
+        kHour1To12,
+        kMinute,
+        kSecond,
+        kFraction,
+        kAmPm
+    };
+
+    struct Step {
+        EField field;
+        int count;
+        std::string literal;
+    };
+
+    static bool isNumeric(EField field);
+
+    bool compile(const UnicodeString& pattern);
+    bool parseWithICU(const std::string& utf8, DateFields& fields);
+    void readFields(DateFields& fields);
+
+    DateFormat* m_format;
+    Calendar* m_calendar;
+    std::vector<Step> m_steps;
+    NameTrie m_wideMonths;
+    NameTrie m_shortMonths;
+    NameTrie m_wideWeekdays;
+    NameTrie m_shortWeekdays;
+    NameTrie m_ampm;
+    int m_centuryStartYear;
+
+    CompiledDateParser(const CompiledDateParser&);
+    CompiledDateParser& operator=(const CompiledDateParser&);
+};
+
+} // namespace webworks
+
+#endif /* DATE_PARSER_HPP_ */
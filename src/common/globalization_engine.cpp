@@ -0,0 +1,1947 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <unicode/calendar.h>
+#include <unicode/datefmt.h>
+#include <unicode/decimfmt.h>
+#include <unicode/dtfmtsym.h>
+#include <unicode/smpdtfmt.h>
+#include <unicode/ucurr.h>
+#include "compact_encoding.hpp"
+#include "date_parser.hpp"
+#include "locale_cache.hpp"
+#include "number_formatter.hpp"
+#include "number_parser.hpp"
+#include "probes.hpp"
+#include "time_zone_cache.hpp"
+#include "trace.hpp"
+#include "globalization_engine.hpp"
+
+/*
+ * The following constants are defined based on Cordova Globalization
+ * plugin definition. They should match exactly.
+ * https://github.com/apache/cordova-plugin-globalization/blob/master/doc/index.md
+*/
+const int UNKNOWN_ERROR = 0;
+const int FORMATTING_ERROR = 1;
+const int PARSING_ERROR = 2;
+const int PATTERN_ERROR = 3;
+
+namespace webworks {
+
+// Locales kept in the LRU until setCacheCapacity changes it.
+static const size_t kDefaultLocaleCapacity = 4;
+
+// Approximate heap footprint of cache entries, measured with the host build.
+// A date format with its compiled parser holds a calendar and name tables.
+static const size_t kDateParserBytes = 72 * 1024;
+static const size_t kNumberFormatBytes = 11 * 1024;
+static const size_t kNameBytes = 48;
+
+static bool parseJson(const std::string& args, Json::Value& root)
+{
+    TraceSpan span("JSON parse", "json");
+    Json::Reader reader;
+    return reader.parse(args, root);
+}
+
+static std::string writeJson(const Json::Value& root)
+{
+    TraceSpan span("JSON write", "json");
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+std::string errorInJson(int code, const std::string& message)
+{
+    Json::Value error;
+    error["code"] = code;
+    error["message"] = message;
+
+    Json::Value root;
+    root["error"] = error;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(const std::string& value)
+{
+    Json::Value root;
+    root["result"] = value;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(bool value)
+{
+    Json::Value root;
+    root["result"] = value;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(int value)
+{
+    Json::Value root;
+    root["result"] = value;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(double value)
+{
+    Json::Value root;
+    root["result"] = value;
+
+    return writeJson(root);
+}
+
+std::string resultDateInJson(const DateFields& fields)
+{
+    Json::Value result;
+    result["year"] = fields.year;
+    result["month"] = fields.month;
+    result["day"] = fields.day;
+    result["hour"] = fields.hour;
+    result["minute"] = fields.minute;
+    result["second"] = fields.second;
+    result["millisecond"] = fields.millisecond;
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(const std::string& pattern, const std::string& timezone, const std::string& ianaTimezone,
+        int utc_offset, int dst_offset)
+{
+    Json::Value result;
+    result["pattern"] = pattern;
+    result["timezone"] = timezone;
+    result["iana_timezone"] = ianaTimezone;
+    result["utc_offset"] = utc_offset;
+    result["dst_offset"] = dst_offset;
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(const std::string& pattern, const std::string& symbol, int fraction,
+        double rounding, const std::string& positive, const std::string& negative,
+        const std::string& decimal, const std::string& grouping)
+{
+    Json::Value result;
+    result["pattern"] = pattern;
+    result["symbol"] = symbol;
+    result["fraction"] = fraction;
+    result["rounding"] = rounding;
+    result["positive"] = positive;
+    result["negative"] = negative;
+    result["decimal"] = decimal;
+    result["grouping"] = grouping;
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(const std::string& pattern, const std::string& code,
+        int fraction, double rounding,
+        const std::string& decimal, const std::string& grouping)
+{
+    Json::Value result;
+    result["pattern"] = pattern;
+    result["code"] = code;
+    result["fraction"] = fraction;
+    result["rounding"] = rounding;
+    result["decimal"] = decimal;
+    result["grouping"] = grouping;
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+std::string resultInJson(const std::list<std::string>& names)
+{
+    Json::Value result;
+    std::list<std::string>::const_iterator end = names.end();
+    std::list<std::string>::const_iterator iter = names.begin();
+    for (; iter != end; ++iter)
+        result.append(*iter);
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+
+// Holds the cache lock while an entry is looked up or built, so a call
+// made while the prewarm thread builds the same entry waits for it. A null
+// mutex locks nothing, for a batch working on its own copy of a formatter.
+class CacheLock {
+public:
+    explicit CacheLock(pthread_mutex_t* mutex) : m_mutex(mutex) { if (m_mutex) pthread_mutex_lock(m_mutex); }
+    ~CacheLock() { if (m_mutex) pthread_mutex_unlock(m_mutex); }
+
+private:
+    pthread_mutex_t* m_mutex;
+};
+
+GlobalizationEngine::GlobalizationEngine(bool prewarm)
+    : m_prewarming(false)
+    , m_stopPrewarm(false)
+    , m_locales(kDefaultLocaleCapacity)
+{
+    pthread_mutex_init(&m_cacheLock, NULL);
+
+    if (prewarm)
+        m_prewarming = pthread_create(&m_prewarmThread, NULL, prewarmThread, this) == 0;
+}
+
+GlobalizationEngine::~GlobalizationEngine() {
+    if (m_prewarming) {
+        {
+            CacheLock lock(&m_cacheLock);
+            m_stopPrewarm = true;
+        }
+        pthread_join(m_prewarmThread, NULL);
+    }
+
+    pthread_mutex_destroy(&m_cacheLock);
+}
+
+pthread_mutex_t GlobalizationEngine::s_sharedLock = PTHREAD_MUTEX_INITIALIZER;
+GlobalizationEngine* GlobalizationEngine::s_shared = NULL;
+unsigned GlobalizationEngine::s_sharedReferences = 0;
+
+GlobalizationEngine* GlobalizationEngine::acquire(bool prewarm)
+{
+    CacheLock lock(&s_sharedLock);
+    if (!s_shared)
+        s_shared = new GlobalizationEngine(prewarm);
+    ++s_sharedReferences;
+    return s_shared;
+}
+
+void GlobalizationEngine::release(GlobalizationEngine* engine)
+{
+    CacheLock lock(&s_sharedLock);
+    if (engine != s_shared || --s_sharedReferences)
+        return;
+    delete s_shared;
+    s_shared = NULL;
+}
+
+void* GlobalizationEngine::prewarmThread(void* arg)
+{
+    static_cast<GlobalizationEngine*>(arg)->prewarm();
+    return NULL;
+}
+
+CompiledDateParser* GlobalizationEngine::dateParser(LocaleResources& res, DateFormat::EStyle dstyle, DateFormat::EStyle tstyle, int zone)
+{
+    // Styles range from kNone (-1) to kShort (3).
+    int key = zone * 64 + (dstyle + 1) * 8 + (tstyle + 1);
+    std::map<int, CompiledDateParser*>::iterator iter = res.dateParsers.find(key);
+    if (iter != res.dateParsers.end())
+        return iter->second;
+
+    TraceSpan span("DateFormat::createDateTimeInstance", "icu");
+    GLOBALIZATION_PROBE(icu__entry, kProbeCreateDateTimeInstance, res.locale.getName(), 0);
+    DateFormat* df = DateFormat::createDateTimeInstance(dstyle, tstyle, res.locale);
+    GLOBALIZATION_PROBE(icu__return, kProbeCreateDateTimeInstance, res.locale.getName(), df ? 0 : -1);
+    if (!df)
+        return NULL;
+
+    if (zone)
+        df->setTimeZone(m_zones.zone(zone));
+
+    CompiledDateParser* parser = new CompiledDateParser(df);
+    res.dateParsers[key] = parser;
+    res.bytes += kDateParserBytes;
+    return parser;
+}
+
+int GlobalizationEngine::firstDayOfWeek(LocaleResources& res)
+{
+    if (res.firstDayOfWeek)
+        return res.firstDayOfWeek;
+
+    TraceSpan span("Calendar::createInstance", "icu");
+    UErrorCode status = U_ZERO_ERROR;
+    GLOBALIZATION_PROBE(icu__entry, kProbeCalendarCreateInstance, res.locale.getName(), 0);
+    Calendar* cal = Calendar::createInstance(res.locale, status);
+    GLOBALIZATION_PROBE(icu__return, kProbeCalendarCreateInstance, res.locale.getName(), (int) status);
+    if (!cal)
+        return 0;
+    std::auto_ptr<Calendar> deleter(cal);
+
+    UCalendarDaysOfWeek d = cal->getFirstDayOfWeek(status);
+    if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START)
+        return 0;
+
+    res.firstDayOfWeek = d;
+    return d;
+}
+
+// Reads the optional timeZone option, an IANA id such as "Europe/Paris".
+// Without it the default zone is used.
+static bool handleTimeZoneOption(const Json::Value& options, std::string& zone, std::string& error)
+{
+    zone.clear();
+
+    if (!options.isObject())
+        return true;
+
+    Json::Value zv = options["timeZone"];
+    if (zv.isNull())
+        return true;
+
+    if (!zv.isString()) {
+        error = "timeZone is invalid!";
+        return false;
+    }
+
+    zone = zv.asString();
+    if (zone.empty()) {
+        error = "timeZone is empty!";
+        return false;
+    }
+
+    return true;
+}
+
+// Reads the optional locale option, a BCP 47 tag such as "de-CH" or an ICU
+// name such as "de_CH". Without it the default locale is used.
+static bool handleLocaleOption(const Json::Value& options, Locale& locale, std::string& error)
+{
+    locale = Locale::getDefault();
+
+    if (!options.isObject())
+        return true;
+
+    Json::Value lv = options["locale"];
+    if (lv.isNull())
+        return true;
+
+    if (!lv.isString()) {
+        error = "locale is invalid!";
+        return false;
+    }
+
+    std::string name = lv.asString();
+    if (name.empty()) {
+        error = "locale is empty!";
+        return false;
+    }
+
+    std::replace(name.begin(), name.end(), '-', '_');
+    locale = Locale::createFromName(name.c_str());
+    if (locale.isBogus()) {
+        error = "Unsupported locale!";
+        return false;
+    }
+
+    return true;
+}
+
+// The locale an adapter reports for the host, in ICU or BCP 47 form.
+static Locale hostLocale(const std::string& localeName)
+{
+    if (localeName.empty())
+        return Locale::getDefault();
+
+    std::string name = localeName;
+    std::replace(name.begin(), name.end(), '-', '_');
+    return Locale::createFromName(name.c_str());
+}
+
+// The locale option of args, or the host's locale without one.
+static bool requestedLocale(const std::string& args, const std::string& localeName, Locale& locale, std::string& error)
+{
+    locale = hostLocale(localeName);
+    if (args.empty())
+        return true;
+
+    Json::Value root;
+    if (!parseJson(args, root)) {
+        error = "Invalid json data!";
+        return false;
+    }
+
+    Json::Value options = root["options"];
+    if (!options.isObject() || options["locale"].isNull())
+        return true;
+
+    return handleLocaleOption(options, locale, error);
+}
+
+std::string GlobalizationEngine::getPreferredLanguage(const std::string& args, const std::string& localeName)
+{
+    Locale loc;
+    std::string error;
+    if (!requestedLocale(args, localeName, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    const char* lang = loc.getLanguage();
+    if (!lang || !strlen(lang)) {
+        lang = "en";
+    }
+
+    const char* country = loc.getCountry();
+    if (!country || !strlen(country)) {
+        country = "US";
+    }
+
+    return resultInJson(std::string(lang) + "-" + country);
+}
+
+std::string GlobalizationEngine::getLocaleName(const std::string& args, const std::string& localeName)
+{
+    Locale loc;
+    std::string error;
+    if (!requestedLocale(args, localeName, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    const char* lang = loc.getLanguage();
+    if (!lang) {
+        lang = "en";
+    }
+
+    const char* country = loc.getCountry();
+    if (!country) {
+        country = "US";
+    }
+
+    return resultInJson(std::string(lang) + "-" + country);
+}
+
+static bool handleDateOptions(const Json::Value& options, DateFormat::EStyle& dateStyle, DateFormat::EStyle& timeStyle, std::string& error)
+{
+    // This is the default value when no options provided.
+    dateStyle = DateFormat::kShort;
+    timeStyle = DateFormat::kShort;
+
+    if (options.isNull())
+        return true;
+
+    if (!options.isObject()) {
+        error = "Options is invalid!";
+        return false;
+    }
+
+    Json::Value flv = options["formatLength"];
+    if (!flv.isNull()) {
+        if (!flv.isString()) {
+            error = "formatLength is invalid!";
+            return false;
+        }
+
+        std::string format = flv.asString();
+        if (format.empty()) {
+            error = "formatLength is empty!";
+            return false;
+        }
+
+        if (format == "full") {
+            dateStyle = DateFormat::kFull;
+            timeStyle = dateStyle;
+        } else if (format == "long") {
+            dateStyle = DateFormat::kLong;
+            timeStyle = dateStyle;
+        } else if (format == "medium") {
+            dateStyle = DateFormat::kMedium;
+            timeStyle = dateStyle;
+        } else if (format == "short") {
+            // Nothing to change here.
+        } else {
+            error = "Unsupported formatLength!";
+            return false;
+        }
+    }
+
+    Json::Value slv = options["selector"];
+    if (!slv.isNull()) {
+        if (!slv.isString()) {
+            error = "selector is invalid!";
+            return false;
+        }
+
+        std::string selector = slv.asString();
+        if (selector.empty()) {
+            error = "selector is empty!";
+            return false;
+        }
+
+        if (selector == "date")
+            timeStyle = DateFormat::kNone;
+            // Nothing to change here
+        else if (selector == "time")
+            dateStyle = DateFormat::kNone;
+        else if (selector == "date and time") {
+            // Nothing to do here.
+        } else {
+            error = "Unsupported selector!";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string GlobalizationEngine::dateToString(const std::string& args)
+{
+    if (args.empty())
+        return errorInJson(PARSING_ERROR, "No date provided!");
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+    }
+
+    Json::Value date = root["date"];
+    if (date.isNull()) {
+        return errorInJson(PARSING_ERROR, "No date provided!");
+    }
+
+    if (!date.isNumeric()) {
+        return errorInJson(PARSING_ERROR, "Date in wrong format!");
+    }
+
+    Json::Value options = root["options"];
+
+    DateFormat::EStyle dstyle, tstyle;
+    std::string error;
+
+    if (!handleDateOptions(options, dstyle, tstyle, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    std::string zoneId;
+    if (!handleTimeZoneOption(options, zoneId, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    CacheLock lock(&m_cacheLock);
+    int zone = m_zones.find(zoneId);
+    if (zone < 0) {
+        return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+    }
+
+    CompiledDateParser* parser = dateParser(*m_locales.get(loc), dstyle, tstyle, zone);
+    if (!parser) {
+        return errorInJson(UNKNOWN_ERROR, "Unable to create DateFormat instance!");
+    }
+
+    std::string utf8;
+    {
+        TraceSpan span("DateFormat::format", "format");
+        UnicodeString result;
+        parser->format()->format(date.asDouble(), result);
+        result.toUTF8String(utf8);
+    }
+    return resultInJson(utf8);
+}
+
+std::string GlobalizationEngine::stringToDate(const std::string& args)
+{
+    if (args.empty())
+        return errorInJson(PARSING_ERROR, "No dateString provided!");
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+    }
+
+    Json::Value dateString = root["dateString"];
+    if (!dateString.isString()) {
+        return errorInJson(PARSING_ERROR, "dateString not a string!");
+    }
+
+    std::string dateValue = dateString.asString();
+    if (dateValue.empty()) {
+        return errorInJson(PARSING_ERROR, "dateString is empty!");
+    }
+
+    Json::Value options = root["options"];
+
+    DateFormat::EStyle dstyle, tstyle;
+    std::string error;
+    if (!handleDateOptions(options, dstyle, tstyle, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    std::string zoneId;
+    if (!handleTimeZoneOption(options, zoneId, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    CacheLock lock(&m_cacheLock);
+    int zone = m_zones.find(zoneId);
+    if (zone < 0) {
+        return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+    }
+
+    CompiledDateParser* parser = dateParser(*m_locales.get(loc), dstyle, tstyle, zone);
+    if (!parser) {
+        return errorInJson(UNKNOWN_ERROR, "Unable to create DateFormat instance!");
+    }
+
+    DateFields fields;
+    bool parsed;
+    {
+        TraceSpan span("CompiledDateParser::parse", "format");
+        parsed = parser->parse(dateValue, fields);
+    }
+    if (!parsed) {
+        return errorInJson(PARSING_ERROR, "Failed to parse dateString!");
+    }
+
+    return resultDateInJson(fields);
+}
+
+std::string GlobalizationEngine::getDatePattern(const std::string& args)
+{
+    DateFormat::EStyle dstyle = DateFormat::kShort, tstyle = DateFormat::kShort;
+    Locale loc = Locale::getDefault();
+    std::string zoneId;
+
+    if (!args.empty()) {
+        Json::Value root;
+        bool parse = parseJson(args, root);
+
+        if (!parse) {
+            return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+        }
+
+        Json::Value options = root["options"];
+
+        std::string error;
+        if (!handleDateOptions(options, dstyle, tstyle, error))
+            return errorInJson(PARSING_ERROR, error);
+
+        if (!handleLocaleOption(options, loc, error))
+            return errorInJson(PARSING_ERROR, error);
+
+        if (!handleTimeZoneOption(options, zoneId, error))
+            return errorInJson(PARSING_ERROR, error);
+    }
+
+    CacheLock lock(&m_cacheLock);
+    int zone = m_zones.find(zoneId);
+    if (zone < 0) {
+        return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+    }
+
+    CompiledDateParser* parser = dateParser(*m_locales.get(loc), dstyle, tstyle, zone);
+    if (!parser) {
+        return errorInJson(UNKNOWN_ERROR, "Unable to create DateFormat instance!");
+    }
+
+    DateFormat* df = parser->format();
+    if (df->getDynamicClassID() != SimpleDateFormat::getStaticClassID()) {
+        return errorInJson(UNKNOWN_ERROR, "DateFormat instance not SimpleDateFormat!");
+    }
+
+    SimpleDateFormat* sdf = (SimpleDateFormat*) df;
+
+    UnicodeString pt;
+    sdf->toPattern(pt);
+    std::string ptUtf8;
+    pt.toUTF8String(ptUtf8);
+
+    // The short name and UTC offset as they are now, standard or daylight.
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t rawOffset = 0, dstOffset = 0;
+    m_zones.getOffset(zone, Calendar::getNow(), rawOffset, dstOffset, status);
+    if (U_FAILURE(status)) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to get the time zone offset!");
+    }
+
+    const TimeZone& tz = m_zones.zone(zone);
+    UnicodeString id;
+    tz.getID(id);
+    std::string idUtf8;
+    id.toUTF8String(idUtf8);
+
+    int utc_offset = (rawOffset + dstOffset) / 1000; // UTC_OFFSET in seconds.
+    int dst_offset = tz.getDSTSavings() / 1000; // DST_OFFSET in seconds;
+
+    return resultInJson(ptUtf8, m_zones.shortName(zone, loc, dstOffset != 0), idUtf8, utc_offset, dst_offset);
+}
+
+enum ENamesType {
+    kNamesWide,
+    kNamesNarrow,
+    kNameWidthCount
+};
+
+enum ENamesItem {
+    kNamesMonths,
+    kNamesDays,
+    kNamesTypeCount
+};
+
+static bool handleNamesOptions(const Json::Value& options, ENamesType& type, ENamesItem& item, std::string& error)
+{
+    // This is the default value when no options provided.
+    type = kNamesWide;
+    item = kNamesMonths;
+
+    if (options.isNull())
+        return true;
+
+    if (!options.isObject()) {
+        error = "Options is invalid!";
+        return false;
+    }
+
+    Json::Value tv = options["type"];
+    if (!tv.isNull()) {
+        if (!tv.isString()) {
+            error = "type is invalid!";
+            return false;
+        }
+
+        std::string tstr = tv.asString();
+        if (tstr.empty()) {
+            error = "type is empty!";
+            return false;
+        }
+
+        if (tstr == "narrow") {
+            type = kNamesNarrow;
+        } else if (tstr == "wide") {
+            // Nothing to change here.
+        } else {
+            error = "Unsupported type!";
+            return false;
+        }
+    }
+
+    Json::Value iv = options["item"];
+    if (!iv.isNull()) {
+        if (!iv.isString()) {
+            error = "item is invalid!";
+            return false;
+        }
+
+        std::string istr = iv.asString();
+        if (istr.empty()) {
+            error = "item is empty!";
+            return false;
+        }
+
+        if (istr == "days") {
+            item = kNamesDays;
+        } else if (istr == "months") {
+            // Nothing to change here.
+        } else {
+            error = "Unsupported item!";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string GlobalizationEngine::getDateNames(const std::string& args)
+{
+    ENamesType type = kNamesWide;
+    ENamesItem item = kNamesMonths;
+    Locale loc = Locale::getDefault();
+
+    if (!args.empty()) {
+        Json::Value root;
+        bool parse = parseJson(args, root);
+
+        if (!parse) {
+            return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+        }
+
+        Json::Value options = root["options"];
+
+        std::string error;
+        if (!handleNamesOptions(options, type, item, error))
+            return errorInJson(PARSING_ERROR, error);
+
+        if (!handleLocaleOption(options, loc, error))
+            return errorInJson(PARSING_ERROR, error);
+    }
+
+    int code;
+    std::string error;
+    CacheLock lock(&m_cacheLock);
+    const std::list<std::string>* names = dateNames(*m_locales.get(loc), type, item, code, error);
+    if (!names) {
+        return errorInJson(code, error);
+    }
+
+    return resultInJson(*names);
+}
+
+const std::list<std::string>* GlobalizationEngine::dateNames(LocaleResources& res, int type, int item, int& code, std::string& error)
+{
+    int key = type * kNamesTypeCount + item;
+    std::map<int, std::list<std::string> >::iterator iter = res.dateNames.find(key);
+    if (iter != res.dateNames.end())
+        return &iter->second;
+
+    int count;
+    const char* pattern;
+    DateFormat::EStyle dstyle;
+
+    // Check ICU SimpleDateFormat document for patterns for months and days.
+    // http://www.icu-project.org/apiref/icu4c/classicu_1_1SimpleDateFormat.html
+    if (item == kNamesMonths) {
+        count = 12;
+        if (type == kNamesWide) {
+            dstyle = DateFormat::kLong;
+            pattern = "MMMM";
+        } else {
+            dstyle = DateFormat::kShort;
+            pattern = "MMM";
+        }
+    } else {
+        count = 7;
+        if (type == kNamesWide) {
+            dstyle = DateFormat::kLong;
+            pattern = "eeee";
+        } else {
+            dstyle = DateFormat::kShort;
+            pattern = "eee";
+        }
+    }
+
+    TraceSpan span("DateFormat::createDateInstance", "icu");
+    UErrorCode status = U_ZERO_ERROR;
+    GLOBALIZATION_PROBE(icu__entry, kProbeCreateDateInstance, res.locale.getName(), 0);
+    DateFormat* df = DateFormat::createDateInstance(dstyle, res.locale);
+    GLOBALIZATION_PROBE(icu__return, kProbeCreateDateInstance, res.locale.getName(), df ? 0 : -1);
+
+    if (!df) {
+        code = UNKNOWN_ERROR;
+        error = "Unable to create DateFormat instance!";
+        return NULL;
+    }
+    std::auto_ptr<DateFormat> deleter(df);
+
+    if (df->getDynamicClassID() != SimpleDateFormat::getStaticClassID()) {
+        code = UNKNOWN_ERROR;
+        error = "DateFormat instance not SimpleDateFormat!";
+        return NULL;
+    }
+
+    SimpleDateFormat* sdf = (SimpleDateFormat*) df;
+    sdf->applyLocalizedPattern(UnicodeString(pattern, -1), status);
+
+    GLOBALIZATION_PROBE(icu__entry, kProbeCalendarCreateInstance, res.locale.getName(), 0);
+    Calendar* cal = Calendar::createInstance(res.locale, status);
+    GLOBALIZATION_PROBE(icu__return, kProbeCalendarCreateInstance, res.locale.getName(), (int) status);
+    if (!cal) {
+        code = UNKNOWN_ERROR;
+        error = "Unable to create Calendar instance!";
+        return NULL;
+    }
+    std::auto_ptr<Calendar> caldeleter(cal);
+
+    int ud = firstDayOfWeek(res);
+    if (!ud) {
+        code = PARSING_ERROR;
+        error = "Failed to getFirstDayOfWeek!";
+        return NULL;
+    }
+
+    if (ud == UCAL_SUNDAY)
+        cal->set(2014, 0, 5);
+    else
+        cal->set(2014, 0, 6);
+
+    std::list<std::string> utf8Names;
+
+    for (int i = 0; i < count; ++i) {
+        UnicodeString ucs;
+        sdf->format(cal->getTime(status), ucs);
+
+        if (item == kNamesMonths)
+            cal->add(UCAL_MONTH, 1, status);
+        else
+            cal->add(UCAL_DAY_OF_MONTH, 1, status);
+
+        if (ucs.isEmpty())
+            continue;
+
+        std::string utf8;
+        ucs.toUTF8String(utf8);
+        utf8Names.push_back(utf8);
+    }
+
+    if (!utf8Names.size()) {
+        code = UNKNOWN_ERROR;
+        error = "Unable to get symbols!";
+        return NULL;
+    }
+
+    std::list<std::string>& names = res.dateNames[key];
+    names.swap(utf8Names);
+    for (std::list<std::string>::iterator name = names.begin(); name != names.end(); ++name)
+        res.bytes += kNameBytes + name->size();
+    return &names;
+}
+
+std::string GlobalizationEngine::isDayLightSavingsTime(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(UNKNOWN_ERROR, "No date is provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+    }
+
+    Json::Value dv = root["date"];
+
+    if (!dv.isNumeric()) {
+        return errorInJson(PARSING_ERROR, "Invalid date format!");
+    }
+
+    double date = dv.asDouble();
+
+    std::string zoneId, error;
+    if (!handleTimeZoneOption(root["options"], zoneId, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    CacheLock lock(&m_cacheLock);
+    int zone = m_zones.find(zoneId);
+    if (zone < 0) {
+        return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+    }
+
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = m_zones.inDaylightTime(zone, date, status);
+
+    return resultInJson(result);
+}
+
+std::string GlobalizationEngine::getFirstDayOfWeek(const std::string& args)
+{
+    Locale loc = Locale::getDefault();
+
+    if (!args.empty()) {
+        Json::Value root;
+        bool parse = parseJson(args, root);
+
+        if (!parse) {
+            return errorInJson(PARSING_ERROR, "Parameters not valid json format!");
+        }
+
+        std::string error;
+        if (!handleLocaleOption(root["options"], loc, error))
+            return errorInJson(PARSING_ERROR, error);
+    }
+
+    CacheLock lock(&m_cacheLock);
+    int d = firstDayOfWeek(*m_locales.get(loc));
+    if (!d) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to call getFirstDayOfWeek!");
+    }
+
+    return resultInJson(d);
+}
+
+enum ENumberType {
+    kNumberDecimal,
+    kNumberCurrency,
+    kNumberPercent,
+    kNumberTypeCount
+};
+
+static bool handleNumberOptions(const Json::Value& options, ENumberType& type, std::string& error)
+{
+    if (options.isNull())
+        return true;
+
+    if (!options.isObject()) {
+        error = "Invalid options type!";
+        return false;
+    }
+
+    // An options object may carry only a locale or a time zone, the type
+    // then stays at its default.
+    Json::Value tv = options["type"];
+    if (tv.isNull())
+        return true;
+
+    if (!tv.isString()) {
+        error = "Invalid type type!";
+        return false;
+    }
+
+    std::string tstr = tv.asString();
+    if (tstr.empty()) {
+        error = "Empty type!";
+        return false;
+    }
+
+    if (tstr == "currency") {
+        type = kNumberCurrency;
+    } else if (tstr == "percent") {
+        type = kNumberPercent;
+    } else if (tstr == "decimal") {
+        type = kNumberDecimal;
+    } else {
+        error = "Unsupported type!";
+        return false;
+    }
+
+    return true;
+}
+
+static NumberFormat* createNumberFormat(ENumberType type, const Locale& loc, UErrorCode& status)
+{
+    int site = type == kNumberCurrency ? kProbeCreateCurrencyInstance : kProbeNumberFormatCreateInstance;
+    GLOBALIZATION_PROBE(icu__entry, site, loc.getName(), 0);
+
+    NumberFormat* nf;
+    switch (type) {
+    case kNumberDecimal:
+    default:
+        nf = NumberFormat::createInstance(loc, status);
+        break;
+    case kNumberCurrency:
+        nf = NumberFormat::createCurrencyInstance(loc, status);
+        break;
+    case kNumberPercent:
+        nf = NumberFormat::createPercentInstance(loc, status);
+        break;
+    }
+
+    GLOBALIZATION_PROBE(icu__return, site, loc.getName(), (int) status);
+    return nf;
+}
+
+NumberParser* GlobalizationEngine::numberParser(LocaleResources& res, int type)
+{
+    std::map<int, NumberParser*>::iterator iter = res.numberParsers.find(type);
+    if (iter != res.numberParsers.end())
+        return iter->second;
+
+    TraceSpan span("NumberFormat::createInstance", "icu");
+    UErrorCode status = U_ZERO_ERROR;
+    NumberFormat* nf = createNumberFormat((ENumberType) type, res.locale, status);
+    if (!nf)
+        return NULL;
+
+    NumberParser* parser = new NumberParser(nf, type == kNumberCurrency);
+    res.numberParsers[type] = parser;
+    res.bytes += kNumberFormatBytes;
+    return parser;
+}
+
+NumberFormatter* GlobalizationEngine::numberFormatter(LocaleResources& res, int type)
+{
+    std::map<int, NumberFormatter*>::iterator iter = res.numberFormatters.find(type);
+    if (iter != res.numberFormatters.end())
+        return iter->second;
+
+    TraceSpan span("NumberFormat::createInstance", "icu");
+    UErrorCode status = U_ZERO_ERROR;
+    NumberFormat* nf = createNumberFormat((ENumberType) type, res.locale, status);
+    if (!nf)
+        return NULL;
+
+    NumberFormatter* formatter = new NumberFormatter(nf, type == kNumberCurrency);
+    res.numberFormatters[type] = formatter;
+    res.bytes += kNumberFormatBytes;
+    return formatter;
+}
+
+std::string GlobalizationEngine::numberToString(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(UNKNOWN_ERROR, "No arguments provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Invalid json data!");
+    }
+
+    Json::Value nv = root["number"];
+    if (nv.isNull()) {
+        return errorInJson(FORMATTING_ERROR, "No number provided!");
+    }
+
+    if (!nv.isNumeric()) {
+        return errorInJson(FORMATTING_ERROR, "Invalid number type!");
+    }
+
+    // This is the default value when no options provided.
+    ENumberType type = kNumberDecimal;
+
+    Json::Value options = root["options"];
+    std::string error;
+    if (!handleNumberOptions(options, type, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    CacheLock lock(&m_cacheLock);
+    NumberFormatter* formatter = numberFormatter(*m_locales.get(loc), type);
+    if (!formatter) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+    }
+
+    std::string utf8;
+    {
+        TraceSpan span("NumberFormatter::format", "format");
+        formatter->format(nv.asDouble(), utf8);
+    }
+
+    return resultInJson(utf8);
+}
+
+std::string GlobalizationEngine::stringToNumber(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(PARSING_ERROR, "No arguments provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Invalid json data!");
+    }
+
+    Json::Value sv = root["numberString"];
+    if (sv.isNull()) {
+        return errorInJson(FORMATTING_ERROR, "No numberString provided!");
+    }
+
+    if (!sv.isString()) {
+        return errorInJson(FORMATTING_ERROR, "Invalid numberString type!");
+    }
+
+    std::string str = sv.asString();
+    if (str.empty()) {
+        return errorInJson(FORMATTING_ERROR, "Empty numberString!");
+    }
+
+    // This is the default value when no options provided.
+    ENumberType type = kNumberDecimal;
+
+    Json::Value options = root["options"];
+    std::string error;
+    if (!handleNumberOptions(options, type, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    CacheLock lock(&m_cacheLock);
+    NumberParser* parser = numberParser(*m_locales.get(loc), type);
+    if (!parser) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+    }
+
+    UErrorCode status = U_ZERO_ERROR;
+    Formattable value;
+    {
+        TraceSpan span("NumberParser::parse", "format");
+        parser->parse(str, value, status);
+    }
+
+    if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START) {
+        return errorInJson(PARSING_ERROR, "Failed to parse string!");
+    }
+
+    if (!value.isNumeric()) {
+        return errorInJson(FORMATTING_ERROR, "String is not numeric!");
+    }
+
+    // getDouble() without a status does not convert integral results.
+    return resultInJson(value.getDouble(status));
+}
+
+// Collects the per-element results of a batch command: a value for each
+// element, null where it failed, and { index, code, message } in errors
+// for each failure. With the compact encoding the values go straight into
+// the binary form described in compact_encoding.hpp. A streamed command
+// flushes each chunk to its sink, and toString() then only summarizes.
+class BatchResult {
+public:
+    explicit BatchResult(EResultEncoding encoding)
+        : m_encoding(encoding)
+        , m_streamed(false)
+        , m_first(0)
+        , m_count(0)
+        , m_errorCount(0)
+        , m_totalErrors(0)
+        , m_values(Json::arrayValue)
+        , m_errors(Json::arrayValue)
+    {
+    }
+
+    void append(const std::string& value)
+    {
+        if (m_encoding == kEncodingCompact) {
+            m_compactValues.putByte(kCompactString);
+            m_compactValues.putString(value);
+        } else {
+            m_values.append(value);
+        }
+        ++m_count;
+    }
+
+    void append(double value)
+    {
+        if (m_encoding == kEncodingCompact) {
+            m_compactValues.putByte(kCompactNumber);
+            m_compactValues.putDouble(value);
+        } else {
+            m_values.append(value);
+        }
+        ++m_count;
+    }
+
+    // Error indexes count from the start of the whole batch.
+    void fail(int code, const std::string& message)
+    {
+        if (m_encoding == kEncodingCompact) {
+            m_compactErrors.putUInt32(m_first + m_count);
+            m_compactErrors.putByte((unsigned char) code);
+            m_compactErrors.putString(message);
+            m_compactValues.putByte(kCompactNull);
+        } else {
+            Json::Value error;
+            error["index"] = m_first + m_count;
+            error["code"] = code;
+            error["message"] = message;
+            m_errors.append(error);
+            m_values.append(Json::Value());
+        }
+        ++m_count;
+        ++m_errorCount;
+    }
+
+    // Hands the elements since the last flush to the sink and starts a new
+    // chunk; false when the sink wants no more.
+    bool flush(BatchSink& sink)
+    {
+        bool more = sink.chunk(chunkString());
+        m_streamed = true;
+        m_first += m_count;
+        m_totalErrors += m_errorCount;
+        m_count = 0;
+        m_errorCount = 0;
+        m_values = Json::Value(Json::arrayValue);
+        m_errors = Json::Value(Json::arrayValue);
+        m_compactValues = CompactWriter();
+        m_compactErrors = CompactWriter();
+        return more;
+    }
+
+    std::string toString() const
+    {
+        if (!m_streamed)
+            return chunkString();
+
+        Json::Value root;
+        root["result"]["count"] = m_first;
+        root["result"]["errors"] = m_totalErrors;
+        return writeJson(root);
+    }
+
+private:
+    std::string chunkString() const
+    {
+        if (m_encoding == kEncodingCompact) {
+            TraceSpan span("compact write", "json");
+            CompactWriter writer;
+            writer.putUInt32(m_count);
+            writer.append(m_compactValues);
+            writer.putUInt32(m_errorCount);
+            writer.append(m_compactErrors);
+            return base64Encode(writer.bytes());
+        }
+
+        Json::Value root;
+        root["result"]["value"] = m_values;
+        root["result"]["errors"] = m_errors;
+        return writeJson(root);
+    }
+
+    EResultEncoding m_encoding;
+    bool m_streamed;
+    unsigned m_first;
+    unsigned m_count;
+    unsigned m_errorCount;
+    unsigned m_totalErrors;
+    Json::Value m_values;
+    Json::Value m_errors;
+    CompactWriter m_compactValues;
+    CompactWriter m_compactErrors;
+};
+
+// Batches up to this many elements format with the cached formatter under
+// the cache lock. Longer ones format with their own copy of it outside the
+// lock, so they neither hold up other calls nor wait for them.
+static const size_t kLockedBatchLimit = 256;
+
+// Elements per chunk: the whole batch at once unless it is streamed.
+static size_t chunkSize(BatchSink* sink, size_t count)
+{
+    return sink ? sink->chunkSize() : std::max<size_t>(count, 1);
+}
+
+// Reads the array named key and the shared options of a batch command.
+// Where packing is given the array may also be a packed string, see
+// NumberBatch.
+static bool parseBatch(const std::string& args, const char* key, Json::Value& values, Json::Value& options, std::string& error,
+        Json::Value* packing = NULL)
+{
+    Json::Value root;
+    if (args.empty() || !parseJson(args, root)) {
+        error = "Invalid json data!";
+        return false;
+    }
+
+    // isArray() is also true for null.
+    values = root[key];
+    if (values.isNull() || !(values.isArray() || (packing && values.isString()))) {
+        error = std::string("No ") + key + " array provided!";
+        return false;
+    }
+
+    options = root["options"];
+    if (packing)
+        *packing = root["packing"];
+    return true;
+}
+
+// The numbers of dateToStringBatch and numberToStringBatch: a JSON array,
+// or a string of base64 little-endian Float64 or Int64 values with
+// "packing" set to "float64" or "int64". Packed input is decoded in one
+// pass without parsing any number text.
+class NumberBatch {
+public:
+    NumberBatch() : m_packed(false), m_json(NULL) {}
+
+    bool parse(const Json::Value& values, const Json::Value& packing, std::string& error)
+    {
+        if (!values.isString()) {
+            m_json = &values;
+            return true;
+        }
+
+        bool int64 = packing.isString() && packing.asString() == "int64";
+        if (!int64 && !(packing.isString() && packing.asString() == "float64")) {
+            error = "Unsupported packing!";
+            return false;
+        }
+
+        TraceSpan span("packed decode", "json");
+        const std::string& text = values.asString();
+        std::vector<unsigned char> bytes(base64DecodedSize(text.size()));
+        size_t decoded;
+        if (!base64Decode(text.data(), text.size(), bytes.empty() ? NULL : (char*) &bytes[0], decoded)
+                || decoded % 8) {
+            error = "Invalid packed data!";
+            return false;
+        }
+
+        m_packed = true;
+        m_numbers.resize(decoded / 8);
+        for (size_t i = 0; i < m_numbers.size(); ++i) {
+            unsigned long long bits = 0;
+            for (int b = 7; b >= 0; --b)
+                bits = bits << 8 | bytes[i * 8 + b];
+
+            if (int64) {
+                m_numbers[i] = (double) (long long) bits;
+            } else {
+                memcpy(&m_numbers[i], &bits, sizeof(bits));
+            }
+        }
+        return true;
+    }
+
+    size_t size() const
+    {
+        return m_packed ? m_numbers.size() : m_json->size();
+    }
+
+    // False when the element is not a number.
+    bool get(size_t index, double& value) const
+    {
+        if (m_packed) {
+            value = m_numbers[index];
+            return true;
+        }
+
+        const Json::Value& element = (*m_json)[(Json::Value::UInt) index];
+        if (!element.isNumeric())
+            return false;
+        value = element.asDouble();
+        return true;
+    }
+
+private:
+    bool m_packed;
+    // The values passed to parse, which outlive the batch.
+    const Json::Value* m_json;
+    std::vector<double> m_numbers;
+};
+
+std::string GlobalizationEngine::dateToStringBatch(const std::string& args, EResultEncoding encoding, BatchSink* sink)
+{
+    Json::Value values, options, packing;
+    std::string error;
+    NumberBatch dates;
+    if (!parseBatch(args, "dates", values, options, error, &packing) || !dates.parse(values, packing, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    DateFormat::EStyle dstyle, tstyle;
+    if (!handleDateOptions(options, dstyle, tstyle, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    std::string zoneId;
+    if (!handleTimeZoneOption(options, zoneId, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    // One lookup and one formatter per chunk, which is the whole batch
+    // unless it is streamed, or one copy for a batch too long to format
+    // under the cache lock.
+    std::auto_ptr<CompiledDateParser> copy;
+    if (dates.size() > kLockedBatchLimit) {
+        CacheLock lock(&m_cacheLock);
+        int zone = m_zones.find(zoneId);
+        if (zone < 0)
+            return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+
+        CompiledDateParser* parser = dateParser(*m_locales.get(loc), dstyle, tstyle, zone);
+        if (!parser)
+            return errorInJson(UNKNOWN_ERROR, "Unable to create DateFormat instance!");
+        copy.reset(new CompiledDateParser(static_cast<DateFormat*>(parser->format()->clone())));
+    }
+
+    BatchResult batch(encoding);
+    std::string utf8;
+    double date;
+    size_t chunk = chunkSize(sink, dates.size());
+    for (size_t first = 0; first == 0 || first < dates.size(); first += chunk) {
+        {
+            CacheLock lock(copy.get() ? NULL : &m_cacheLock);
+            CompiledDateParser* parser = copy.get();
+            if (!parser) {
+                int zone = m_zones.find(zoneId);
+                if (zone < 0) {
+                    return errorInJson(PARSING_ERROR, "Unsupported timeZone!");
+                }
+
+                parser = dateParser(*m_locales.get(loc), dstyle, tstyle, zone);
+                if (!parser) {
+                    return errorInJson(UNKNOWN_ERROR, "Unable to create DateFormat instance!");
+                }
+            }
+
+            TraceSpan span("DateFormat::format", "format");
+            for (size_t i = first; i < std::min(first + chunk, dates.size()); ++i) {
+                if (!dates.get(i, date)) {
+                    batch.fail(PARSING_ERROR, "Date in wrong format!");
+                    continue;
+                }
+
+                UnicodeString result;
+                parser->format()->format(date, result);
+                utf8.clear();
+                result.toUTF8String(utf8);
+                batch.append(utf8);
+            }
+        }
+
+        if (sink && !batch.flush(*sink))
+            return errorInJson(UNKNOWN_ERROR, "Cancelled!");
+    }
+    return batch.toString();
+}
+
+std::string GlobalizationEngine::numberToStringBatch(const std::string& args, EResultEncoding encoding, BatchSink* sink)
+{
+    Json::Value values, options, packing;
+    std::string error;
+    NumberBatch numbers;
+    if (!parseBatch(args, "numbers", values, options, error, &packing) || !numbers.parse(values, packing, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    ENumberType type = kNumberDecimal;
+    if (!handleNumberOptions(options, type, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    std::auto_ptr<NumberFormatter> copy;
+    if (numbers.size() > kLockedBatchLimit) {
+        CacheLock lock(&m_cacheLock);
+        NumberFormatter* formatter = numberFormatter(*m_locales.get(loc), type);
+        if (!formatter)
+            return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+        copy.reset(new NumberFormatter(static_cast<NumberFormat*>(formatter->numberFormat()->clone()),
+                type == kNumberCurrency));
+    }
+
+    BatchResult batch(encoding);
+    std::string utf8;
+    double number;
+    size_t chunk = chunkSize(sink, numbers.size());
+    for (size_t first = 0; first == 0 || first < numbers.size(); first += chunk) {
+        {
+            CacheLock lock(copy.get() ? NULL : &m_cacheLock);
+            NumberFormatter* formatter = copy.get() ? copy.get() : numberFormatter(*m_locales.get(loc), type);
+            if (!formatter) {
+                return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+            }
+
+            TraceSpan span("NumberFormatter::format", "format");
+            for (size_t i = first; i < std::min(first + chunk, numbers.size()); ++i) {
+                if (!numbers.get(i, number)) {
+                    batch.fail(FORMATTING_ERROR, "Invalid number type!");
+                    continue;
+                }
+
+                formatter->format(number, utf8);
+                batch.append(utf8);
+            }
+        }
+
+        if (sink && !batch.flush(*sink))
+            return errorInJson(UNKNOWN_ERROR, "Cancelled!");
+    }
+    return batch.toString();
+}
+
+std::string GlobalizationEngine::stringToNumberBatch(const std::string& args, EResultEncoding encoding, BatchSink* sink)
+{
+    Json::Value strings, options;
+    std::string error;
+    if (!parseBatch(args, "numberStrings", strings, options, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    ENumberType type = kNumberDecimal;
+    if (!handleNumberOptions(options, type, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    std::auto_ptr<NumberParser> copy;
+    if (strings.size() > kLockedBatchLimit) {
+        CacheLock lock(&m_cacheLock);
+        NumberParser* parser = numberParser(*m_locales.get(loc), type);
+        if (!parser)
+            return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+        copy.reset(new NumberParser(static_cast<NumberFormat*>(parser->format()->clone()),
+                type == kNumberCurrency));
+    }
+
+    BatchResult batch(encoding);
+    size_t chunk = chunkSize(sink, strings.size());
+    for (size_t first = 0; first == 0 || first < strings.size(); first += chunk) {
+        {
+            CacheLock lock(copy.get() ? NULL : &m_cacheLock);
+            NumberParser* parser = copy.get() ? copy.get() : numberParser(*m_locales.get(loc), type);
+            if (!parser) {
+                return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+            }
+
+            TraceSpan span("NumberParser::parse", "format");
+            for (size_t i = first; i < std::min(first + chunk, (size_t) strings.size()); ++i) {
+                const Json::Value& numberString = strings[(Json::Value::UInt) i];
+                if (!numberString.isString() || numberString.asString().empty()) {
+                    batch.fail(FORMATTING_ERROR, "Invalid numberString type!");
+                    continue;
+                }
+
+                UErrorCode status = U_ZERO_ERROR;
+                Formattable value;
+                parser->parse(numberString.asString(), value, status);
+                if (status != U_ZERO_ERROR && status != U_ERROR_WARNING_START) {
+                    batch.fail(PARSING_ERROR, "Failed to parse string!");
+                } else if (!value.isNumeric()) {
+                    batch.fail(FORMATTING_ERROR, "String is not numeric!");
+                } else {
+                    batch.append(value.getDouble(status));
+                }
+            }
+        }
+
+        if (sink && !batch.flush(*sink))
+            return errorInJson(UNKNOWN_ERROR, "Cancelled!");
+    }
+    return batch.toString();
+}
+
+std::string GlobalizationEngine::getNumberPattern(const std::string& args)
+{
+    // This is the default value when no options provided.
+    ENumberType type = kNumberDecimal;
+    Locale loc = Locale::getDefault();
+
+    if (!args.empty()) {
+        Json::Value root;
+        bool parse = parseJson(args, root);
+
+        if (!parse) {
+            return errorInJson(PARSING_ERROR, "Invalid json data!");
+        }
+
+        Json::Value options = root["options"];
+        std::string error;
+        if (!handleNumberOptions(options, type, error))
+            return errorInJson(PARSING_ERROR, error);
+
+        if (!handleLocaleOption(options, loc, error))
+            return errorInJson(PARSING_ERROR, error);
+    }
+
+    std::string pattern, symbol, positive, negative, decimal, grouping;
+    int fraction;
+    double rounding;
+
+    // The pattern is read from the formatter numberToString uses.
+    CacheLock lock(&m_cacheLock);
+    NumberFormatter* formatter = numberFormatter(*m_locales.get(loc), type);
+    if (!formatter) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to create NumberFormat instance!");
+    }
+
+    NumberFormat* nf = formatter->numberFormat();
+    if (nf->getDynamicClassID() != DecimalFormat::getStaticClassID()) {
+        return errorInJson(UNKNOWN_ERROR, "DecimalFormat expected!");
+    }
+
+    DecimalFormat* df = (DecimalFormat*) nf;
+    const DecimalFormatSymbols* dfs = df->getDecimalFormatSymbols();
+    if (!dfs) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to get DecimalFormatSymbols instance!");
+    }
+
+    UnicodeString ucs;
+
+    df->toPattern(ucs);
+    ucs.toUTF8String(pattern);
+    ucs.remove();
+
+    df->getPositivePrefix(ucs);
+    if (ucs.isEmpty())
+        df->getPositiveSuffix(ucs);
+    ucs.toUTF8String(positive);
+    ucs.remove();
+
+    df->getNegativePrefix(ucs);
+    if (ucs.isEmpty())
+        df->getNegativeSuffix(ucs);
+    ucs.toUTF8String(negative);
+    ucs.remove();
+
+    rounding = df->getRoundingIncrement();
+    fraction = df->getMaximumFractionDigits();
+
+    ucs = dfs->getSymbol(DecimalFormatSymbols::kDecimalSeparatorSymbol);
+    ucs.toUTF8String(decimal);
+    ucs.remove();
+
+    ucs = dfs->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol);
+    ucs.toUTF8String(grouping);
+    ucs.remove();
+
+    if (type == kNumberPercent)
+        ucs = dfs->getSymbol(DecimalFormatSymbols::kPercentSymbol);
+    else if (type == kNumberCurrency)
+        ucs = dfs->getSymbol(DecimalFormatSymbols::kCurrencySymbol);
+    else
+        ucs = dfs->getSymbol(DecimalFormatSymbols::kDigitSymbol);
+
+    ucs.toUTF8String(symbol);
+    ucs.remove();
+
+    return resultInJson(pattern, symbol, fraction, rounding, positive, negative, decimal, grouping);
+}
+
+std::string GlobalizationEngine::getCurrencyPattern(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(UNKNOWN_ERROR, "No arguments provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Invalid json data!");
+    }
+
+    Json::Value ccv = root["currencyCode"];
+    if (ccv.isNull()) {
+        return errorInJson(FORMATTING_ERROR, "No currencyCode provided!");
+    }
+
+    if (!ccv.isString()) {
+        return errorInJson(FORMATTING_ERROR, "Invalid currencyCode type!");
+    }
+
+    std::string cc = ccv.asString();
+    if (cc.empty()) {
+        return errorInJson(FORMATTING_ERROR, "Empty currencyCode!");
+    }
+
+    Json::Value options = root["options"];
+    std::string error;
+    Locale loc;
+    if (!handleLocaleOption(options, loc, error))
+        return errorInJson(PARSING_ERROR, error);
+
+    UnicodeString ucc = UnicodeString::fromUTF8(cc);
+    DecimalFormat* df = 0;
+    int count = 0;
+    const Locale* locs = Locale::getAvailableLocales(count);
+
+    // With a locale, the currency is shown the way that locale shows it.
+    if (options.isObject() && !options["locale"].isNull()) {
+        UErrorCode status = U_ZERO_ERROR;
+        UBool isChoiceFormat;
+        int32_t length;
+        ucurr_getName(ucc.getTerminatedBuffer(), loc.getName(), UCURR_SYMBOL_NAME, &isChoiceFormat, &length, &status);
+        // Unknown codes come back as the code itself with a default warning.
+        bool known = U_SUCCESS(status) && status != U_USING_DEFAULT_WARNING;
+        status = U_ZERO_ERROR;
+        TraceSpan span("NumberFormat::createCurrencyInstance", "icu");
+        NumberFormat* nf = 0;
+        if (known) {
+            GLOBALIZATION_PROBE(icu__entry, kProbeCreateCurrencyInstance, loc.getName(), 0);
+            nf = NumberFormat::createCurrencyInstance(loc, status);
+            GLOBALIZATION_PROBE(icu__return, kProbeCreateCurrencyInstance, loc.getName(), (int) status);
+        }
+        if (nf && nf->getDynamicClassID() == DecimalFormat::getStaticClassID()) {
+            nf->setCurrency(ucc.getTerminatedBuffer(), status);
+            df = (DecimalFormat*) nf;
+        } else {
+            delete nf;
+        }
+        count = 0;
+    }
+
+    TraceSpan scan("NumberFormat::createCurrencyInstance", "icu", count ? "all locales" : 0);
+    for (int i = 0; i < count; ++i) {
+        UErrorCode status = U_ZERO_ERROR;
+        GLOBALIZATION_PROBE(icu__entry, kProbeCreateCurrencyInstance, locs[i].getName(), 0);
+        NumberFormat* nf = NumberFormat::createCurrencyInstance(*(locs + i), status);
+        GLOBALIZATION_PROBE(icu__return, kProbeCreateCurrencyInstance, locs[i].getName(), (int) status);
+        if (!nf) {
+            continue;
+        }
+        std::auto_ptr<NumberFormat> ndeleter(nf);
+
+        const UChar* currency = nf->getCurrency();
+        if (!currency) {
+            continue;
+        }
+
+        if (!ucc.compare(currency, -1)) {
+            df = (DecimalFormat*) ndeleter.release();
+            break;
+        }
+    }
+
+    if (!df)
+        return errorInJson(UNKNOWN_ERROR, "Currency not supported!");
+
+    std::auto_ptr<DecimalFormat> deleter(df);
+
+    const DecimalFormatSymbols* dfs = df->getDecimalFormatSymbols();
+    if (!dfs) {
+        return errorInJson(UNKNOWN_ERROR, "Failed to get DecimalFormatSymbols!");
+    }
+
+    UnicodeString ucs;
+
+    std::string pattern;
+    df->toPattern(ucs);
+    ucs.toUTF8String(pattern);
+    ucs.remove();
+
+    int fraction = df->getMaximumFractionDigits();
+    double rounding = df->getRoundingIncrement();
+
+    std::string decimal;
+    ucs = dfs->getSymbol(DecimalFormatSymbols::kDecimalSeparatorSymbol);
+    ucs.toUTF8String(decimal);
+    ucs.remove();
+
+    std::string grouping;
+    ucs = dfs->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol);
+    ucs.toUTF8String(grouping);
+    ucs.remove();
+
+    return resultInJson(pattern, cc, fraction, rounding, decimal, grouping);
+}
+
+std::string GlobalizationEngine::getCacheStats()
+{
+    CacheLock lock(&m_cacheLock);
+
+    Json::Value result;
+    result["capacity"] = (Json::UInt) m_locales.capacity();
+    result["locales"] = (Json::UInt) m_locales.size();
+    result["hits"] = (Json::UInt) m_locales.hits();
+    result["misses"] = (Json::UInt) m_locales.misses();
+    result["evictions"] = (Json::UInt) m_locales.evictions();
+    result["bytes"] = (Json::UInt) m_locales.bytes();
+    result["zones"] = (Json::UInt) m_zones.size();
+
+    Json::Value root;
+    root["result"] = result;
+
+    return writeJson(root);
+}
+
+std::string GlobalizationEngine::setCacheCapacity(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(UNKNOWN_ERROR, "No arguments provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Invalid json data!");
+    }
+
+    Json::Value cv = root["capacity"];
+    if (!cv.isIntegral() || cv.asInt() < 1) {
+        return errorInJson(PARSING_ERROR, "capacity must be a positive integer!");
+    }
+
+    CacheLock lock(&m_cacheLock);
+    m_locales.setCapacity(cv.asInt());
+    return resultInJson((int) m_locales.capacity());
+}
+
+std::string GlobalizationEngine::setTransitionWindow(const std::string& args)
+{
+    if (args.empty()) {
+        return errorInJson(UNKNOWN_ERROR, "No arguments provided!");
+    }
+
+    Json::Value root;
+    bool parse = parseJson(args, root);
+
+    if (!parse) {
+        return errorInJson(PARSING_ERROR, "Invalid json data!");
+    }
+
+    Json::Value fv = root["firstYear"];
+    Json::Value lv = root["lastYear"];
+    if (!fv.isIntegral() || !lv.isIntegral()) {
+        return errorInJson(PARSING_ERROR, "firstYear and lastYear must be integers!");
+    }
+
+    if (fv.asInt() > lv.asInt()) {
+        return errorInJson(PARSING_ERROR, "firstYear is after lastYear!");
+    }
+
+    CacheLock lock(&m_cacheLock);
+    m_zones.setTransitionWindow(fv.asInt(), lv.asInt());
+    return resultInJson(true);
+}
+
+// Builds what the default options of dateToString, stringToDate,
+// getDateNames and the number methods use for the default locale, in the
+// order an application typically needs them while drawing its first screen.
+void GlobalizationEngine::prewarm()
+{
+    static const int names[][2] = {
+        { kNamesWide, kNamesMonths },
+        { kNamesWide, kNamesDays },
+        { kNamesNarrow, kNamesMonths },
+        { kNamesNarrow, kNamesDays }
+    };
+
+    Locale loc = Locale::getDefault();
+    int code;
+    std::string error;
+
+    for (int step = 0; ; ++step) {
+        CacheLock lock(&m_cacheLock);
+        if (m_stopPrewarm)
+            return;
+
+        LocaleResources& res = *m_locales.prepare(loc);
+        if (step == 0) {
+            dateParser(res, DateFormat::kShort, DateFormat::kShort);
+        } else if (step == 1) {
+            numberFormatter(res, kNumberDecimal);
+        } else if (step < 6) {
+            dateNames(res, names[step - 2][0], names[step - 2][1], code, error);
+        } else if (step < 6 + kNumberTypeCount) {
+            numberFormatter(res, step - 6);
+            numberParser(res, step - 6);
+        } else {
+            return;
+        }
+    }
+}
+
+} /* namespace webworks */
@@ -0,0 +1,146 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef GLOBALIZATION_ENGINE_HPP_
+#define GLOBALIZATION_ENGINE_HPP_
+
+#include <list>
+#include <pthread.h>
+#include <string>
+#include <unicode/datefmt.h>
+#include "compact_encoding.hpp"
+#include "locale_cache.hpp"
+#include "time_zone_cache.hpp"
+
+// The engine names ICU classes unqualified on every host, whatever
+// U_USING_ICU_NAMESPACE defaults to there.
+U_NAMESPACE_USE
+
+namespace webworks {
+
+// Receives the results of a streamed batch command chunk by chunk.
+class BatchSink {
+public:
+    virtual ~BatchSink() {}
+
+    // Elements per chunk, at least one.
+    virtual size_t chunkSize() const = 0;
+
+    // Takes one chunk, encoded like a whole batch result; returning false
+    // stops the command.
+    virtual bool chunk(const std::string& result) = 0;
+};
+
+/*
+ * The twelve Cordova Globalization operations and their batch forms over
+ * ICU, shared by the BlackBerry 10 and Ubuntu plugins. Arguments and
+ * results are the JSON of the BlackBerry 10 JavaScript bridge: every
+ * operation takes its arguments as one JSON object and returns either
+ * {"result": ...} or {"error": {"code": ..., "message": ...}}. The
+ * platform adapters translate their own calls into that and read the
+ * host's language, locale and time zone themselves.
+ */
+class GlobalizationEngine {
+public:
+	// With prewarm set, the formatters used by the default options are built
+	// for the current locale on a background thread.
+	explicit GlobalizationEngine(bool prewarm = false);
+	virtual ~GlobalizationEngine();
+
+	// The engine shared by every Globalization object, so the caches below
+	// exist once per process. The first acquire creates it and the last
+	// release destroys it.
+	static GlobalizationEngine* acquire(bool prewarm);
+	static void release(GlobalizationEngine* engine);
+
+	// The extension methods are defined here
+
+    // Both answer for the locale option in args when there is one, and
+    // otherwise for localeName, the host's locale as an ICU or BCP 47 name,
+    // or for ICU's default locale when that is empty.
+    std::string getPreferredLanguage(const std::string& args, const std::string& localeName = std::string());
+
+    std::string getLocaleName(const std::string& args, const std::string& localeName = std::string());
+
+    std::string dateToString(const std::string& args);
+
+    std::string stringToDate(const std::string& args);
+
+    std::string getDatePattern(const std::string& args);
+
+    std::string getDateNames(const std::string& args);
+
+    std::string isDayLightSavingsTime(const std::string& args);
+
+    std::string getFirstDayOfWeek(const std::string& args);
+
+    std::string numberToString(const std::string& args);
+
+    std::string stringToNumber(const std::string& args);
+
+    std::string getNumberPattern(const std::string& args);
+
+    std::string getCurrencyPattern(const std::string& args);
+
+    // Batch forms of dateToString, numberToString and stringToNumber: one
+    // set of options and one cached formatter for the whole array, copied
+    // for long arrays, with per-element errors in the result. With a sink
+    // the results go to it in chunks and the return value only counts
+    // elements and errors.
+    std::string dateToStringBatch(const std::string& args, EResultEncoding encoding = kEncodingJson,
+            BatchSink* sink = NULL);
+
+    std::string numberToStringBatch(const std::string& args, EResultEncoding encoding = kEncodingJson,
+            BatchSink* sink = NULL);
+
+    std::string stringToNumberBatch(const std::string& args, EResultEncoding encoding = kEncodingJson,
+            BatchSink* sink = NULL);
+
+    std::string getCacheStats();
+
+    std::string setCacheCapacity(const std::string& args);
+
+    std::string setTransitionWindow(const std::string& args);
+
+private:
+    static void* prewarmThread(void* arg);
+    void prewarm();
+
+    // Callers hold m_cacheLock while using what these return.
+    CompiledDateParser* dateParser(LocaleResources& res, DateFormat::EStyle dstyle, DateFormat::EStyle tstyle, int zone = 0);
+    const std::list<std::string>* dateNames(LocaleResources& res, int type, int item, int& code, std::string& error);
+    NumberParser* numberParser(LocaleResources& res, int type);
+    NumberFormatter* numberFormatter(LocaleResources& res, int type);
+    int firstDayOfWeek(LocaleResources& res);
+
+    // Guards the caches below, which the prewarm thread fills concurrently.
+    pthread_mutex_t m_cacheLock;
+    pthread_t m_prewarmThread;
+    bool m_prewarming;
+    bool m_stopPrewarm;
+    LocaleCache m_locales;
+    // Zones named by the timeZone option, shared by all locales.
+    TimeZoneCache m_zones;
+
+    static pthread_mutex_t s_sharedLock;
+    static GlobalizationEngine* s_shared;
+    static unsigned s_sharedReferences;
+
+    GlobalizationEngine(const GlobalizationEngine&);
+    GlobalizationEngine& operator=(const GlobalizationEngine&);
+};
+
+} // namespace webworks
+
+#endif /* GLOBALIZATION_ENGINE_HPP_ */
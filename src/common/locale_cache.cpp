@@ -0,0 +1,111 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "date_parser.hpp"
+#include "locale_cache.hpp"
+#include "number_formatter.hpp"
+#include "number_parser.hpp"
+
+namespace webworks {
+
+LocaleResources::LocaleResources(const Locale& loc)
+    : locale(loc)
+    , firstDayOfWeek(0)
+    , bytes(sizeof(LocaleResources))
+{
+}
+
+LocaleResources::~LocaleResources()
+{
+    std::map<int, CompiledDateParser*>::iterator iter = dateParsers.begin();
+    for (; iter != dateParsers.end(); ++iter)
+        delete iter->second;
+
+    std::map<int, NumberParser*>::iterator niter = numberParsers.begin();
+    for (; niter != numberParsers.end(); ++niter)
+        delete niter->second;
+
+    std::map<int, NumberFormatter*>::iterator fiter = numberFormatters.begin();
+    for (; fiter != numberFormatters.end(); ++fiter)
+        delete fiter->second;
+}
+
+LocaleCache::LocaleCache(size_t capacity)
+    : m_capacity(capacity ? capacity : 1)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+LocaleCache::~LocaleCache()
+{
+    trim(0);
+}
+
+LocaleResources* LocaleCache::get(const Locale& locale)
+{
+    return lookup(locale, true);
+}
+
+LocaleResources* LocaleCache::prepare(const Locale& locale)
+{
+    return lookup(locale, false);
+}
+
+LocaleResources* LocaleCache::lookup(const Locale& locale, bool counted)
+{
+    std::string name = locale.getName();
+    std::map<std::string, EntryList::iterator>::iterator iter = m_index.find(name);
+    if (iter != m_index.end()) {
+        if (counted)
+            ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, iter->second);
+        return *iter->second;
+    }
+
+    if (counted)
+        ++m_misses;
+    trim(m_capacity - 1);
+    m_entries.push_front(new LocaleResources(locale));
+    m_index[name] = m_entries.begin();
+    return m_entries.front();
+}
+
+void LocaleCache::setCapacity(size_t capacity)
+{
+    m_capacity = capacity ? capacity : 1;
+    trim(m_capacity);
+}
+
+size_t LocaleCache::bytes() const
+{
+    size_t total = 0;
+    for (EntryList::const_iterator iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+        total += (*iter)->bytes;
+    return total;
+}
+
+void LocaleCache::trim(size_t capacity)
+{
+    while (m_entries.size() > capacity) {
+        LocaleResources* entry = m_entries.back();
+        m_entries.pop_back();
+        m_index.erase(entry->locale.getName());
+        delete entry;
+        ++m_evictions;
+    }
+}
+
+} // namespace webworks
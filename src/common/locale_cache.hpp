@@ -0,0 +1,107 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef LOCALE_CACHE_HPP_
+#define LOCALE_CACHE_HPP_
+
+#include <list>
+#include <map>
+#include <string>
+#include <unicode/locid.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+class CompiledDateParser;
+class NumberFormatter;
+class NumberParser;
+
+/**
+ * Formatters, parsers and symbol tables built for one locale.
+ *
+ * The maps are filled lazily by GlobalizationEngine, which also adds the
+ * approximate heap footprint of every entry it creates to bytes.
+ */
+struct LocaleResources {
+    explicit LocaleResources(const Locale& loc);
+    ~LocaleResources();
+
+    Locale locale;
+    // Date formats and their compiled parsers, keyed by date and time style.
+    std::map<int, CompiledDateParser*> dateParsers;
+    // getDateNames results, keyed by names type and item.
+    std::map<int, std::list<std::string> > dateNames;
+    // stringToNumber parsers, keyed by number type.
+    std::map<int, NumberParser*> numberParsers;
+    // numberToString formatters, keyed by number type.
+    std::map<int, NumberFormatter*> numberFormatters;
+    // UCalendarDaysOfWeek, or 0 until first requested.
+    int firstDayOfWeek;
+    size_t bytes;
+
+private:
+    LocaleResources(const LocaleResources&);
+    LocaleResources& operator=(const LocaleResources&);
+};
+
+/**
+ * Least recently used set of LocaleResources keyed by ICU locale name.
+ *
+ * Lookups are counted as hits or misses, and locales beyond the capacity
+ * are evicted together with everything built for them.
+ */
+class LocaleCache {
+public:
+    explicit LocaleCache(size_t capacity);
+    ~LocaleCache();
+
+    // Never returns NULL. The result stays valid until a later get() or
+    // setCapacity() evicts it.
+    LocaleResources* get(const Locale& locale);
+
+    // Same as get(), but counted as neither a hit nor a miss, for work done
+    // ahead of any call such as prewarming.
+    LocaleResources* prepare(const Locale& locale);
+
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return m_capacity; }
+    size_t size() const { return m_index.size(); }
+    size_t bytes() const;
+
+    unsigned long hits() const { return m_hits; }
+    unsigned long misses() const { return m_misses; }
+    unsigned long evictions() const { return m_evictions; }
+
+private:
+    typedef std::list<LocaleResources*> EntryList;
+
+    LocaleResources* lookup(const Locale& locale, bool counted);
+    void trim(size_t capacity);
+
+    // Most recently used first.
+    EntryList m_entries;
+    std::map<std::string, EntryList::iterator> m_index;
+    size_t m_capacity;
+    unsigned long m_hits;
+    unsigned long m_misses;
+    unsigned long m_evictions;
+
+    LocaleCache(const LocaleCache&);
+    LocaleCache& operator=(const LocaleCache&);
+};
+
+} // namespace webworks
+
+#endif /* LOCALE_CACHE_HPP_ */
@@ -0,0 +1,284 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <string>
+#include <unicode/decimfmt.h>
+#include "number_formatter.hpp"
+
+namespace webworks {
+
+static const int kMaxScale = 15;
+
+static const double kPowersOfTen[kMaxScale + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15
+};
+
+static const unsigned long long kIntegerPowersOfTen[kMaxScale + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL
+};
+
+// ICU rounds the shortest decimal representation of the double, which is
+// within half an ulp of it. Scaled values stay below 1e14 so the integer
+// part is exact, and anything within kRelativeSlack of a rounding tie is
+// left to ICU rather than guessing which way it goes.
+static const double kMaxScaled = 1e14;
+static const double kRelativeSlack = 8.8817841970012523e-16; // 2^-50
+
+static const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of n backwards ending at end, two at a time.
+static char* writeDigits(unsigned long long n, char* end)
+{
+    char* p = end;
+    while (n >= 100) {
+        unsigned int pair = (unsigned int) (n % 100) * 2;
+        n /= 100;
+        *--p = kDigitPairs[pair + 1];
+        *--p = kDigitPairs[pair];
+    }
+
+    if (n >= 10) {
+        unsigned int pair = (unsigned int) n * 2;
+        *--p = kDigitPairs[pair + 1];
+        *--p = kDigitPairs[pair];
+    } else {
+        *--p = '0' + (char) n;
+    }
+    return p;
+}
+
+static std::string toUTF8(const UnicodeString& ucs)
+{
+    std::string utf8;
+    ucs.toUTF8String(utf8);
+    return utf8;
+}
+
+NumberFormatter::NumberFormatter(NumberFormat* nf, bool currency)
+    : m_format(nf)
+    , m_compiled(false)
+    , m_nativeDigits(false)
+    , m_groupingUsed(false)
+    , m_primaryGroup(0)
+    , m_secondaryGroup(0)
+    , m_minGrouping(1)
+    , m_minFraction(0)
+    , m_maxFraction(0)
+    , m_scale(0)
+{
+    // Currency output depends on currency digits and cash rounding.
+    if (currency || !m_format || m_format->getDynamicClassID() != DecimalFormat::getStaticClassID())
+        return;
+
+    DecimalFormat* df = (DecimalFormat*) m_format;
+    const DecimalFormatSymbols* dfs = df->getDecimalFormatSymbols();
+    if (!dfs || df->isScientificNotation() || df->areSignificantDigitsUsed()
+            || df->isDecimalSeparatorAlwaysShown() || df->getFormatWidth() > 0
+            || df->getRoundingIncrement() != 0.0
+            || df->getRoundingMode() != DecimalFormat::kRoundHalfEven
+            || df->getMinimumIntegerDigits() != 1)
+        return;
+
+    int32_t multiplier = df->getMultiplier();
+    if (multiplier == 100)
+        m_scale = 2;
+    else if (multiplier != 1)
+        return;
+
+    m_minFraction = df->getMinimumFractionDigits();
+    m_maxFraction = df->getMaximumFractionDigits();
+    if (m_maxFraction + m_scale > kMaxScale || m_minFraction > m_maxFraction)
+        return;
+
+    m_decimal = toUTF8(dfs->getSymbol(DecimalFormatSymbols::kDecimalSeparatorSymbol));
+    m_grouping = toUTF8(dfs->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol));
+    m_groupingUsed = df->isGroupingUsed() && !m_grouping.empty();
+    m_primaryGroup = df->getGroupingSize();
+    m_secondaryGroup = df->getSecondaryGroupingSize();
+    if (m_secondaryGroup <= 0)
+        m_secondaryGroup = m_primaryGroup;
+    if (m_groupingUsed && (m_primaryGroup <= 0 || m_primaryGroup > kMaxScale))
+        return;
+
+    static const DecimalFormatSymbols::ENumberFormatSymbol digits[10] = {
+        DecimalFormatSymbols::kZeroDigitSymbol,
+        DecimalFormatSymbols::kOneDigitSymbol,
+        DecimalFormatSymbols::kTwoDigitSymbol,
+        DecimalFormatSymbols::kThreeDigitSymbol,
+        DecimalFormatSymbols::kFourDigitSymbol,
+        DecimalFormatSymbols::kFiveDigitSymbol,
+        DecimalFormatSymbols::kSixDigitSymbol,
+        DecimalFormatSymbols::kSevenDigitSymbol,
+        DecimalFormatSymbols::kEightDigitSymbol,
+        DecimalFormatSymbols::kNineDigitSymbol
+    };
+    for (int i = 0; i < 10; ++i) {
+        m_digits[i] = toUTF8(dfs->getSymbol(digits[i]));
+        if (m_digits[i].empty())
+            return;
+        if (m_digits[i].size() != 1 || m_digits[i][0] != '0' + i)
+            m_nativeDigits = true;
+    }
+
+    UnicodeString ucs;
+    m_positivePrefix = toUTF8(df->getPositivePrefix(ucs));
+    m_positiveSuffix = toUTF8(df->getPositiveSuffix(ucs));
+    m_negativePrefix = toUTF8(df->getNegativePrefix(ucs));
+    m_negativeSuffix = toUTF8(df->getNegativeSuffix(ucs));
+
+    // Some locales only group once there are two digits in front of the
+    // first separator (1234 but 12 345). Ask ICU instead of relying on the
+    // minimum grouping digits API, which older ICU does not have.
+    if (m_groupingUsed) {
+        UnicodeString probe;
+        m_format->format(kPowersOfTen[m_primaryGroup] / kPowersOfTen[m_scale], probe);
+        if (probe.indexOf(dfs->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol)) < 0)
+            m_minGrouping = 2;
+    }
+
+    m_compiled = true;
+    m_compiled = selfCheck();
+}
+
+NumberFormatter::~NumberFormatter()
+{
+    delete m_format;
+}
+
+// Compares a few representative values with ICU, so that any pattern
+// feature not modelled above disables the fast path instead of leaking
+// different output.
+bool NumberFormatter::selfCheck()
+{
+    static const double probes[] = {
+        0, 1, 7, 12, 123, 1234, 12345, 123456, 1234567, 12345678, 123456789,
+        0.5, 0.25, 1.5, 0.001, 0.1234, 3.14159, 1234.5678, 98765.4321,
+        -1, -12345.678, -0.75, 1000000.01, 2e9 + 0.3
+    };
+
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); ++i) {
+        double probe = probes[i] / kPowersOfTen[m_scale];
+        std::string fast;
+        if (!formatFast(probe, fast))
+            continue;
+
+        UnicodeString ucs;
+        m_format->format(probe, ucs);
+        if (fast != toUTF8(ucs))
+            return false;
+    }
+
+    return true;
+}
+
+bool NumberFormatter::formatFast(double value, std::string& utf8) const
+{
+    if (!m_compiled || value != value)
+        return false;
+
+    bool negative = value < 0;
+    double scaled = (negative ? -value : value) * kPowersOfTen[m_maxFraction + m_scale];
+    if (!(scaled < kMaxScaled))
+        return false;
+
+    double whole = std::floor(scaled);
+    double rest = scaled - whole;
+    if (std::fabs(rest - 0.5) <= scaled * kRelativeSlack)
+        return false;
+
+    unsigned long long units = (unsigned long long) whole + (rest > 0.5 ? 1 : 0);
+
+    // ICU keeps the sign of values that round to zero ("-0").
+    if (!units && (negative || 1 / value < 0))
+        return false;
+
+    unsigned long long integer = units / kIntegerPowersOfTen[m_maxFraction];
+    unsigned long long fraction = units % kIntegerPowersOfTen[m_maxFraction];
+
+    int fractionDigits = m_maxFraction;
+    while (fractionDigits > m_minFraction && fraction % 10 == 0) {
+        fraction /= 10;
+        --fractionDigits;
+    }
+
+    char buffer[48];
+    char* end = buffer + sizeof(buffer);
+    char* fractionStart = end;
+    if (fractionDigits) {
+        fractionStart = writeDigits(fraction, end);
+        while (end - fractionStart < fractionDigits)
+            *--fractionStart = '0';
+    }
+    char* integerEnd = fractionStart;
+    char* integerStart = writeDigits(integer, integerEnd);
+
+    int integerDigits = integerEnd - integerStart;
+    bool group = m_groupingUsed && integerDigits >= m_primaryGroup + m_minGrouping;
+
+    utf8.clear();
+    utf8.reserve(32);
+    utf8.append(negative ? m_negativePrefix : m_positivePrefix);
+
+    for (int i = 0; i < integerDigits; ++i) {
+        char digit = integerStart[i];
+        if (m_nativeDigits)
+            utf8.append(m_digits[digit - '0']);
+        else
+            utf8.push_back(digit);
+
+        int remaining = integerDigits - 1 - i;
+        if (group && remaining >= m_primaryGroup && (remaining - m_primaryGroup) % m_secondaryGroup == 0)
+            utf8.append(m_grouping);
+    }
+
+    if (fractionDigits) {
+        utf8.append(m_decimal);
+        for (const char* p = fractionStart; p < end; ++p) {
+            if (m_nativeDigits)
+                utf8.append(m_digits[*p - '0']);
+            else
+                utf8.push_back(*p);
+        }
+    }
+
+    utf8.append(negative ? m_negativeSuffix : m_positiveSuffix);
+    return true;
+}
+
+void NumberFormatter::format(double value, std::string& utf8)
+{
+    if (formatFast(value, utf8))
+        return;
+
+    UnicodeString result;
+    m_format->format(value, result);
+    utf8.clear();
+    result.toUTF8String(utf8);
+}
+
+} // namespace webworks
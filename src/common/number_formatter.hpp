@@ -0,0 +1,75 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef NUMBER_FORMATTER_HPP_
+#define NUMBER_FORMATTER_HPP_
+
+#include <string>
+#include <unicode/numfmt.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+/**
+ * Decimal and percent formatter precomputed from a cached DecimalFormat.
+ *
+ * Grouping sizes, separators, affixes, native digits and fraction digit
+ * limits are read once. Values whose rounding is unambiguous are then
+ * written with a two-digits-at-a-time integer to ASCII routine, inserting
+ * separators inline. Ties, very large values, currency and any pattern
+ * feature not modelled here are formatted by ICU.
+ */
+class NumberFormatter {
+public:
+    // Takes ownership of the NumberFormat.
+    NumberFormatter(NumberFormat* nf, bool currency);
+    ~NumberFormatter();
+
+    void format(double value, std::string& utf8);
+
+    // Runs the precomputed formatter only, false means the value needs ICU.
+    bool formatFast(double value, std::string& utf8) const;
+
+    bool isCompiled() const { return m_compiled; }
+    NumberFormat* numberFormat() const { return m_format; }
+
+private:
+    bool selfCheck();
+
+    NumberFormat* m_format;
+    bool m_compiled;
+    std::string m_positivePrefix;
+    std::string m_positiveSuffix;
+    std::string m_negativePrefix;
+    std::string m_negativeSuffix;
+    std::string m_decimal;
+    std::string m_grouping;
+    std::string m_digits[10];
+    bool m_nativeDigits;
+    bool m_groupingUsed;
+    int m_primaryGroup;
+    int m_secondaryGroup;
+    int m_minGrouping;
+    int m_minFraction;
+    int m_maxFraction;
+    int m_scale;
+
+    NumberFormatter(const NumberFormatter&);
+    NumberFormatter& operator=(const NumberFormatter&);
+};
+
+} // namespace webworks
+
+#endif /* NUMBER_FORMATTER_HPP_ */
@@ -0,0 +1,257 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <string>
+#include <unicode/curramt.h>
+#include <unicode/decimfmt.h>
+#include <unicode/parsepos.h>
+#include "number_parser.hpp"
+
+namespace webworks {
+
+// Up to 15 significant digits the mantissa is exact in a double, and so is
+// every power of ten up to 1e22. A single division of the two is then
+// correctly rounded, which is also what ICU returns.
+static const int kMaxSignificantDigits = 15;
+static const int kMaxScale = 22;
+
+static const double kPowersOfTen[kMaxScale + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static std::string toUTF8(const UnicodeString& ucs)
+{
+    std::string utf8;
+    ucs.toUTF8String(utf8);
+    return utf8;
+}
+
+static bool startsWith(const char* p, const char* end, const std::string& s)
+{
+    return (size_t) (end - p) >= s.size() && !memcmp(p, s.data(), s.size());
+}
+
+NumberParser::NumberParser(NumberFormat* nf, bool currency)
+    : m_format(nf)
+    , m_currency(currency)
+    , m_nativeDigits(false)
+    , m_groupingUsed(false)
+    , m_primaryGroup(0)
+    , m_secondaryGroup(0)
+    , m_scale(0)
+{
+    if (!m_format || m_format->getDynamicClassID() != DecimalFormat::getStaticClassID())
+        return;
+
+    DecimalFormat* df = (DecimalFormat*) m_format;
+    const DecimalFormatSymbols* dfs = df->getDecimalFormatSymbols();
+    if (!dfs || df->isScientificNotation())
+        return;
+
+    int32_t multiplier = df->getMultiplier();
+    if (multiplier == 100)
+        m_scale = 2;
+    else if (multiplier != 1)
+        return;
+
+    m_decimal = toUTF8(dfs->getSymbol(DecimalFormatSymbols::kDecimalSeparatorSymbol));
+    m_grouping = toUTF8(dfs->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol));
+    m_groupingUsed = df->isGroupingUsed() && !m_grouping.empty();
+    m_primaryGroup = df->getGroupingSize();
+    m_secondaryGroup = df->getSecondaryGroupingSize();
+    if (m_secondaryGroup <= 0)
+        m_secondaryGroup = m_primaryGroup;
+    if (m_decimal.empty() || (m_groupingUsed && m_primaryGroup <= 0))
+        return;
+
+    static const DecimalFormatSymbols::ENumberFormatSymbol digits[10] = {
+        DecimalFormatSymbols::kZeroDigitSymbol,
+        DecimalFormatSymbols::kOneDigitSymbol,
+        DecimalFormatSymbols::kTwoDigitSymbol,
+        DecimalFormatSymbols::kThreeDigitSymbol,
+        DecimalFormatSymbols::kFourDigitSymbol,
+        DecimalFormatSymbols::kFiveDigitSymbol,
+        DecimalFormatSymbols::kSixDigitSymbol,
+        DecimalFormatSymbols::kSevenDigitSymbol,
+        DecimalFormatSymbols::kEightDigitSymbol,
+        DecimalFormatSymbols::kNineDigitSymbol
+    };
+    for (int i = 0; i < 10; ++i) {
+        m_digits[i] = toUTF8(dfs->getSymbol(digits[i]));
+        if (m_digits[i].empty())
+            return;
+        if (m_digits[i].size() != 1 || m_digits[i][0] != '0' + i)
+            m_nativeDigits = true;
+    }
+
+    // Negative affixes go first so "-" is never taken for an empty prefix.
+    UnicodeString ucs;
+    Affixes negative;
+    negative.prefix = toUTF8(df->getNegativePrefix(ucs));
+    negative.suffix = toUTF8(df->getNegativeSuffix(ucs));
+    negative.negative = true;
+
+    Affixes positive;
+    positive.prefix = toUTF8(df->getPositivePrefix(ucs));
+    positive.suffix = toUTF8(df->getPositiveSuffix(ucs));
+    positive.negative = false;
+
+    if (negative.prefix == positive.prefix && negative.suffix == positive.suffix)
+        return;
+
+    m_affixes.push_back(negative);
+    m_affixes.push_back(positive);
+}
+
+NumberParser::~NumberParser()
+{
+    delete m_format;
+}
+
+int NumberParser::digitAt(const char*& p, const char* end) const
+{
+    if (*p >= '0' && *p <= '9')
+        return *p++ - '0';
+
+    if (m_nativeDigits && (unsigned char) *p >= 0x80) {
+        for (int i = 0; i < 10; ++i) {
+            if (startsWith(p, end, m_digits[i])) {
+                p += m_digits[i].size();
+                return i;
+            }
+        }
+    }
+
+    return -1;
+}
+
+bool NumberParser::matchDigits(const char* p, const char* end, double& value) const
+{
+    long long mantissa = 0;
+    int significant = 0, integerDigits = 0, fractionDigits = 0, group = 0, groups = 0;
+    int firstGroup = 0;
+    bool fraction = false;
+
+    while (p < end) {
+        int digit = digitAt(p, end);
+        if (digit >= 0) {
+            if (mantissa || digit) {
+                if (++significant > kMaxSignificantDigits)
+                    return false;
+            }
+            mantissa = mantissa * 10 + digit;
+            if (fraction) {
+                ++fractionDigits;
+            } else {
+                ++integerDigits;
+                ++group;
+            }
+            continue;
+        }
+
+        if (!fraction && m_groupingUsed && startsWith(p, end, m_grouping)) {
+            // Only well placed separators, ICU decides about the others.
+            if (!group)
+                return false;
+            if (!groups)
+                firstGroup = group;
+            else if (group != m_secondaryGroup)
+                return false;
+            ++groups;
+            group = 0;
+            p += m_grouping.size();
+            continue;
+        }
+
+        if (!fraction && startsWith(p, end, m_decimal)) {
+            fraction = true;
+            p += m_decimal.size();
+            continue;
+        }
+
+        return false;
+    }
+
+    if (!integerDigits || (fraction && !fractionDigits))
+        return false;
+
+    if (groups) {
+        if (group != m_primaryGroup || firstGroup > (groups > 1 ? m_secondaryGroup : m_primaryGroup))
+            return false;
+    }
+
+    int scale = fractionDigits + m_scale;
+    if (scale > kMaxScale)
+        return false;
+
+    value = (double) mantissa / kPowersOfTen[scale];
+    return true;
+}
+
+bool NumberParser::match(const std::string& utf8, double& value) const
+{
+    const char* begin = utf8.data();
+    const char* end = begin + utf8.size();
+
+    for (size_t i = 0; i < m_affixes.size(); ++i) {
+        const Affixes& affixes = m_affixes[i];
+        if (!startsWith(begin, end, affixes.prefix))
+            continue;
+
+        const char* digits = begin + affixes.prefix.size();
+        const char* suffix = end - affixes.suffix.size();
+        if (suffix <= digits || memcmp(suffix, affixes.suffix.data(), affixes.suffix.size()))
+            continue;
+
+        if (!matchDigits(digits, suffix, value))
+            return false;
+
+        if (affixes.negative) {
+            // ICU keeps the sign of a negative zero, leave it to ICU.
+            if (value == 0)
+                return false;
+            value = -value;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void NumberParser::parse(const std::string& utf8, Formattable& value, UErrorCode& status)
+{
+    double number;
+    if (match(utf8, number)) {
+        value.setDouble(number);
+        return;
+    }
+
+    UnicodeString uStr = UnicodeString::fromUTF8(utf8);
+
+    if (m_currency) {
+        ParsePosition pos;
+        CurrencyAmount* ca = m_format->parseCurrency(uStr, pos);
+        if (ca) {
+            value = ca->getNumber();
+            delete ca;
+            return;
+        }
+    }
+
+    m_format->parse(uStr, value, status);
+}
+
+} // namespace webworks
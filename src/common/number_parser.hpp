@@ -0,0 +1,79 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef NUMBER_PARSER_HPP_
+#define NUMBER_PARSER_HPP_
+
+#include <string>
+#include <vector>
+#include <unicode/fmtable.h>
+#include <unicode/numfmt.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+/**
+ * Number parser driven by the DecimalFormatSymbols and affixes of a cached
+ * DecimalFormat.
+ *
+ * Well formed input ("-1,234.5", "12 %", "1.234,56 €", native digits) is
+ * parsed in one pass over the UTF-8 bytes. Anything else, including values
+ * that can not be converted to a double exactly, is handed to the ICU
+ * lenient parser of the wrapped NumberFormat.
+ */
+class NumberParser {
+public:
+    // Takes ownership of the NumberFormat.
+    NumberParser(NumberFormat* nf, bool currency);
+    ~NumberParser();
+
+    // Same contract as NumberFormat::parse.
+    void parse(const std::string& utf8, Formattable& value, UErrorCode& status);
+
+    // Runs the symbol driven parser only, false means the input needs ICU.
+    bool match(const std::string& utf8, double& value) const;
+
+    bool isCompiled() const { return !m_affixes.empty(); }
+    NumberFormat* format() const { return m_format; }
+
+private:
+    struct Affixes {
+        std::string prefix;
+        std::string suffix;
+        bool negative;
+    };
+
+    bool matchDigits(const char* p, const char* end, double& value) const;
+    int digitAt(const char*& p, const char* end) const;
+
+    NumberFormat* m_format;
+    bool m_currency;
+    std::vector<Affixes> m_affixes;
+    std::string m_decimal;
+    std::string m_grouping;
+    std::string m_digits[10];
+    bool m_nativeDigits;
+    bool m_groupingUsed;
+    int m_primaryGroup;
+    int m_secondaryGroup;
+    int m_scale;
+
+    NumberParser(const NumberParser&);
+    NumberParser& operator=(const NumberParser&);
+};
+
+} // namespace webworks
+
+#endif /* NUMBER_PARSER_HPP_ */
@@ -0,0 +1,33 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "probes.hpp"
+
+#ifdef GLOBALIZATION_HAVE_SDT
+
+// Tracers increment these when they attach; sys/sdt.h expects them in the
+// .probes section.
+#define GLOBALIZATION_DEFINE_PROBE(name) \
+    volatile unsigned short globalization_##name##_semaphore __attribute__((section(".probes"))) = 0
+
+extern "C" {
+GLOBALIZATION_DEFINE_PROBE(invoke__entry);
+GLOBALIZATION_DEFINE_PROBE(invoke__return);
+GLOBALIZATION_DEFINE_PROBE(command__entry);
+GLOBALIZATION_DEFINE_PROBE(command__return);
+GLOBALIZATION_DEFINE_PROBE(icu__entry);
+GLOBALIZATION_DEFINE_PROBE(icu__return);
+}
+
+#endif
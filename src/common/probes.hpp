@@ -0,0 +1,84 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef PROBES_HPP_
+#define PROBES_HPP_
+
+/*
+ * USDT probes for bpftrace, perf and SystemTap, compiled in when the build
+ * finds <sys/sdt.h> (GLOBALIZATION_HAVE_SDT) and empty otherwise. Every
+ * probe is guarded by its semaphore, so its arguments are only computed
+ * while a tracer is attached. All probes are in the "globalization"
+ * provider and take three arguments:
+ *
+ *   invoke__entry    -1, length of the JNEXT command string, 0
+ *   invoke__return   -1, length of the result, 1 if it starts with "Error "
+ *   command__entry   ECommand id, length of the JSON arguments, 0
+ *   command__return  ECommand id, length of the result, 1 for an error result
+ *   icu__entry       EProbeSite id, locale name (char*), 0
+ *   icu__return      EProbeSite id, locale name (char*), UErrorCode, or -1
+ *                    when a call without a status returned NULL
+ *
+ * For example, the latency of dateToString in microseconds:
+ *
+ *   bpftrace -e '
+ *     usdt:libGlobalization.so:globalization:command__entry /arg0 == 2/ { @t[tid] = nsecs; }
+ *     usdt:libGlobalization.so:globalization:command__return /@t[tid]/ {
+ *         @us = hist((nsecs - @t[tid]) / 1000); delete(@t[tid]); }'
+ */
+
+namespace webworks {
+
+// Where an ICU object is constructed, arg0 of the icu probes.
+enum EProbeSite {
+    kProbeCreateDateTimeInstance,
+    kProbeCreateDateInstance,
+    kProbeCalendarCreateInstance,
+    kProbeNumberFormatCreateInstance,
+    kProbeCreateCurrencyInstance
+};
+
+} // namespace webworks
+
+#ifdef GLOBALIZATION_HAVE_SDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define GLOBALIZATION_DECLARE_PROBE(name) \
+    extern "C" volatile unsigned short globalization_##name##_semaphore
+
+GLOBALIZATION_DECLARE_PROBE(invoke__entry);
+GLOBALIZATION_DECLARE_PROBE(invoke__return);
+GLOBALIZATION_DECLARE_PROBE(command__entry);
+GLOBALIZATION_DECLARE_PROBE(command__return);
+GLOBALIZATION_DECLARE_PROBE(icu__entry);
+GLOBALIZATION_DECLARE_PROBE(icu__return);
+
+#define GLOBALIZATION_PROBE(name, arg0, arg1, arg2) \
+    do { \
+        if (__builtin_expect(globalization_##name##_semaphore, 0)) \
+            STAP_PROBE3(globalization, name, arg0, arg1, arg2); \
+    } while (0)
+
+#else
+
+// The arguments are still consumed, so values computed only for a probe
+// do not trip -Wunused-variable; none of them has side effects.
+#define GLOBALIZATION_PROBE(name, arg0, arg1, arg2) \
+    do { (void) (arg0); (void) (arg1); (void) (arg2); } while (0)
+
+#endif
+
+#endif /* PROBES_HPP_ */
@@ -0,0 +1,68 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <time.h>
+#if defined(__QNX__)
+#include <sys/neutrino.h>
+#include <sys/syspage.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#include "tick_clock.hpp"
+
+namespace webworks {
+
+TickClock::TickClock()
+{
+    restart();
+}
+
+void TickClock::restart()
+{
+    m_startTicks = now();
+    m_startNanos = monotonicNanos();
+}
+
+unsigned long long TickClock::now()
+{
+#if defined(__QNX__)
+    return ClockCycles();
+#elif defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return monotonicNanos();
+#endif
+}
+
+unsigned long long TickClock::monotonicNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+double TickClock::nanosPerTick() const
+{
+#if defined(__QNX__)
+    return 1e9 / SYSPAGE_ENTRY(qtime)->cycles_per_sec;
+#elif defined(__i386__) || defined(__x86_64__)
+    unsigned long long elapsedTicks = now() - m_startTicks;
+    unsigned long long elapsedNanos = monotonicNanos() - m_startNanos;
+    return elapsedTicks ? (double) elapsedNanos / elapsedTicks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+} // namespace webworks
@@ -0,0 +1,48 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TICK_CLOCK_HPP_
+#define TICK_CLOCK_HPP_
+
+namespace webworks {
+
+/**
+ * Cheap monotonic timestamps for instrumentation.
+ *
+ * now() reads the cycle counter where there is one (ClockCycles on QNX,
+ * rdtsc on x86), which costs a fraction of clock_gettime. The counter rate
+ * is measured against the monotonic clock from the moment the TickClock
+ * was created, except on QNX where the system page has it.
+ */
+class TickClock {
+public:
+    TickClock();
+
+    static unsigned long long now();
+    static unsigned long long monotonicNanos();
+
+    // Restarts the interval the counter rate is measured over.
+    void restart();
+
+    unsigned long long startTicks() const { return m_startTicks; }
+    double nanosPerTick() const;
+
+private:
+    unsigned long long m_startTicks;
+    unsigned long long m_startNanos;
+};
+
+} // namespace webworks
+
+#endif /* TICK_CLOCK_HPP_ */
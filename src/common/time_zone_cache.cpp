@@ -0,0 +1,163 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_zone_cache.hpp"
+#include "transition_table.hpp"
+
+namespace webworks {
+
+static const size_t kInitialSlots = 16;
+
+// Until setTransitionWindow says otherwise, tables cover the years a
+// signed 32-bit time_t can represent.
+static const int kDefaultFirstYear = 1970;
+static const int kDefaultLastYear = 2037;
+
+TimeZoneCache::TimeZoneCache()
+    : m_firstYear(kDefaultFirstYear)
+    , m_lastYear(kDefaultLastYear)
+{
+    Slot empty = { 0, -1 };
+    m_slots.assign(kInitialSlots, empty);
+
+    // The default zone is not hashed, since it has no id of its own.
+    m_ids.push_back(std::string());
+    m_zones.push_back(TimeZone::createDefault());
+    m_tables.push_back(NULL);
+    m_shortNames.resize(1);
+}
+
+TimeZoneCache::~TimeZoneCache()
+{
+    for (size_t i = 0; i < m_zones.size(); ++i) {
+        delete m_zones[i];
+        delete m_tables[i];
+    }
+}
+
+// FNV-1a.
+unsigned int TimeZoneCache::hash(const std::string& id)
+{
+    unsigned int h = 2166136261U;
+    for (size_t i = 0; i < id.size(); ++i) {
+        h ^= (unsigned char) id[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+int TimeZoneCache::find(const std::string& id)
+{
+    if (id.empty())
+        return 0;
+
+    unsigned int h = hash(id);
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = h & mask; m_slots[i].index >= 0; i = (i + 1) & mask) {
+        if (m_slots[i].hash == h && m_ids[m_slots[i].index] == id)
+            return m_slots[i].index;
+    }
+
+    // ICU falls back to GMT under another id for zones it does not know.
+    UnicodeString uid = UnicodeString::fromUTF8(id);
+    TimeZone* tz = TimeZone::createTimeZone(uid);
+    UnicodeString created;
+    if (!tz || tz->getID(created) != uid) {
+        delete tz;
+        return -1;
+    }
+
+    int index = m_zones.size();
+    m_ids.push_back(id);
+    m_zones.push_back(tz);
+    m_tables.push_back(NULL);
+    m_shortNames.resize(m_zones.size());
+
+    // Keep the load factor at or below one half.
+    if (m_ids.size() * 2 > m_slots.size())
+        grow();
+    else
+        insert(h, index);
+
+    return index;
+}
+
+void TimeZoneCache::insert(unsigned int hash, int index)
+{
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (m_slots[i].index >= 0)
+        i = (i + 1) & mask;
+
+    m_slots[i].hash = hash;
+    m_slots[i].index = index;
+}
+
+void TimeZoneCache::grow()
+{
+    Slot empty = { 0, -1 };
+    m_slots.assign(m_slots.size() * 2, empty);
+    for (size_t index = 1; index < m_ids.size(); ++index)
+        insert(hash(m_ids[index]), index);
+}
+
+void TimeZoneCache::getOffset(int index, UDate date, int32_t& rawOffset, int32_t& dstOffset, UErrorCode& status)
+{
+    if (!m_tables[index])
+        m_tables[index] = new TransitionTable(*m_zones[index], m_firstYear, m_lastYear);
+
+    if (!m_tables[index]->lookup(date, rawOffset, dstOffset))
+        m_zones[index]->getOffset(date, false, rawOffset, dstOffset, status);
+}
+
+// TimeZone::inDaylightTime is a non-zero DST offset at the date.
+bool TimeZoneCache::inDaylightTime(int index, UDate date, UErrorCode& status)
+{
+    int32_t rawOffset, dstOffset;
+    getOffset(index, date, rawOffset, dstOffset, status);
+    return U_SUCCESS(status) && dstOffset != 0;
+}
+
+const std::string& TimeZoneCache::shortName(int index, const Locale& locale, bool daylight)
+{
+    std::map<std::string, ShortNames>& names = m_shortNames[index];
+    std::map<std::string, ShortNames>::iterator iter = names.find(locale.getName());
+    if (iter == names.end()) {
+        ShortNames created;
+        UnicodeString name;
+        m_zones[index]->getDisplayName(false, TimeZone::SHORT, locale, name);
+        name.toUTF8String(created.standard);
+        name.remove();
+        m_zones[index]->getDisplayName(true, TimeZone::SHORT, locale, name);
+        name.toUTF8String(created.daylight);
+        iter = names.insert(std::make_pair(std::string(locale.getName()), created)).first;
+    }
+
+    return daylight ? iter->second.daylight : iter->second.standard;
+}
+
+void TimeZoneCache::setTransitionWindow(int firstYear, int lastYear)
+{
+    if (firstYear == m_firstYear && lastYear == m_lastYear)
+        return;
+
+    m_firstYear = firstYear;
+    m_lastYear = lastYear;
+    for (size_t i = 0; i < m_tables.size(); ++i) {
+        delete m_tables[i];
+        m_tables[i] = NULL;
+    }
+}
+
+} // namespace webworks
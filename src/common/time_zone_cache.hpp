@@ -0,0 +1,98 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TIME_ZONE_CACHE_HPP_
+#define TIME_ZONE_CACHE_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unicode/locid.h>
+#include <unicode/timezone.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+class TransitionTable;
+
+/**
+ * TimeZone objects by IANA id.
+ *
+ * Ids live in an open addressing hash table, so looking up a zone that was
+ * seen before costs one hash and a short probe. Every zone also gets a
+ * small dense index which caches of zone-specific formatters use in their
+ * keys. Index 0 is always the default zone.
+ *
+ * Offset queries are answered from a TransitionTable per zone, built on
+ * first use for the configured window of years.
+ */
+class TimeZoneCache {
+public:
+    TimeZoneCache();
+    ~TimeZoneCache();
+
+    // Returns the index of the zone, 0 for an empty id, or -1 if ICU does
+    // not know the id.
+    int find(const std::string& id);
+
+    const TimeZone& zone(int index) const { return *m_zones[index]; }
+    size_t size() const { return m_zones.size(); }
+
+    // Same results as TimeZone::getOffset for a UTC date.
+    void getOffset(int index, UDate date, int32_t& rawOffset, int32_t& dstOffset, UErrorCode& status);
+    bool inDaylightTime(int index, UDate date, UErrorCode& status);
+
+    // The zone's short standard or daylight name in locale, such as "EST"
+    // and "EDT", computed on first use for each zone and locale.
+    const std::string& shortName(int index, const Locale& locale, bool daylight);
+
+    // Drops the tables built so far if the window changes.
+    void setTransitionWindow(int firstYear, int lastYear);
+    int firstYear() const { return m_firstYear; }
+    int lastYear() const { return m_lastYear; }
+
+private:
+    struct Slot {
+        unsigned int hash;
+        int index;
+    };
+
+    struct ShortNames {
+        std::string standard;
+        std::string daylight;
+    };
+
+    static unsigned int hash(const std::string& id);
+    void insert(unsigned int hash, int index);
+    void grow();
+
+    // Power of two sized, index -1 marks an empty slot.
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_ids;
+    std::vector<TimeZone*> m_zones;
+    // Parallel to m_zones, NULL until the zone is first queried.
+    std::vector<TransitionTable*> m_tables;
+    // Parallel to m_zones, by locale name.
+    std::vector<std::map<std::string, ShortNames> > m_shortNames;
+    int m_firstYear;
+    int m_lastYear;
+
+    TimeZoneCache(const TimeZoneCache&);
+    TimeZoneCache& operator=(const TimeZoneCache&);
+};
+
+} // namespace webworks
+
+#endif /* TIME_ZONE_CACHE_HPP_ */
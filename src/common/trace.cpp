@@ -0,0 +1,136 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "trace.hpp"
+
+namespace webworks {
+
+// seq is the claimed slot index plus one once the event is complete, and
+// zero while a writer is filling it in. generation is the start() the
+// event was recorded under, so events left from an earlier one are told
+// apart without clearing the buffer under writers still running.
+struct Event {
+    volatile unsigned int seq;
+    unsigned int generation;
+    unsigned int thread;
+    const char* name;
+    const char* category;
+    const char* detail;
+    unsigned long long begin;
+    unsigned long long end;
+};
+
+static Event s_events[Trace::kCapacity];
+static unsigned int s_next = 0;
+static volatile unsigned int s_generation = 0;
+static unsigned int s_threads = 0;
+static __thread unsigned int t_thread = 0;
+static TickClock s_clock;
+
+volatile bool Trace::s_enabled = false;
+
+void Trace::start()
+{
+    s_enabled = false;
+    __sync_synchronize();
+    __sync_lock_test_and_set(&s_next, 0);
+    s_clock.restart();
+    __sync_synchronize();
+    // A writer that sees the new generation claims its slot from s_next
+    // reset above; one still on the old generation is skipped by dump().
+    __sync_add_and_fetch(&s_generation, 1);
+    s_enabled = true;
+}
+
+void Trace::stop()
+{
+    s_enabled = false;
+    __sync_synchronize();
+}
+
+void Trace::record(const char* name, const char* category, const char* detail,
+        unsigned long long begin, unsigned long long end)
+{
+    if (!t_thread)
+        t_thread = __sync_add_and_fetch(&s_threads, 1);
+
+    unsigned int generation = s_generation;
+    __sync_synchronize();
+    unsigned int index = __sync_fetch_and_add(&s_next, 1);
+    Event& event = s_events[index % kCapacity];
+    event.seq = 0;
+    __sync_synchronize();
+    event.generation = generation;
+    event.thread = t_thread;
+    event.name = name;
+    event.category = category;
+    event.detail = detail;
+    event.begin = begin;
+    event.end = end;
+    __sync_synchronize();
+    event.seq = index + 1;
+}
+
+int Trace::dump(const std::string& path, std::string& error)
+{
+    // Copy each slot and keep it only if it belongs to the current start()
+    // and no writer touched it meanwhile.
+    unsigned int generation = s_generation;
+    std::vector<Event> events;
+    events.reserve(kCapacity);
+    for (int i = 0; i < kCapacity; ++i) {
+        unsigned int seq = s_events[i].seq;
+        __sync_synchronize();
+        Event copy;
+        memcpy(&copy, (const void*) &s_events[i], sizeof(copy));
+        __sync_synchronize();
+        if (seq && seq == s_events[i].seq && copy.generation == generation)
+            events.push_back(copy);
+    }
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        error = strerror(errno);
+        return -1;
+    }
+
+    double scale = s_clock.nanosPerTick() / 1000;
+    unsigned long long origin = s_clock.startTicks();
+    int pid = getpid();
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+                i ? "," : "", event.name, event.category, (long long) (event.begin - origin) * scale,
+                (event.end - event.begin) * scale, pid, event.thread);
+        if (event.detail)
+            fprintf(file, ",\"args\":{\"detail\":\"%s\"}", event.detail);
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file)) {
+        error = strerror(errno);
+        return -1;
+    }
+    return (int) events.size();
+}
+
+} // namespace webworks
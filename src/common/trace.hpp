@@ -0,0 +1,83 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+
+#include <string>
+#include "tick_clock.hpp"
+
+namespace webworks {
+
+/**
+ * Optional span tracing into a fixed ring buffer.
+ *
+ * While tracing is started every TraceSpan appends one complete event.
+ * Writers claim a slot with a single atomic increment and never block;
+ * once the buffer wraps the oldest events are overwritten. dump() writes
+ * what the buffer holds as Chrome trace_event JSON, which chrome://tracing
+ * and Perfetto open directly. Names, categories and details must be
+ * string literals or otherwise outlive the trace.
+ */
+class Trace {
+public:
+    enum { kCapacity = 16384 };
+
+    static bool enabled() { return s_enabled; }
+    // Starts recording; events from an earlier start are left out of dump().
+    static void start();
+    static void stop();
+
+    static void record(const char* name, const char* category, const char* detail,
+            unsigned long long begin, unsigned long long end);
+
+    // Returns the number of events written, or -1 with error set.
+    static int dump(const std::string& path, std::string& error);
+
+private:
+    static volatile bool s_enabled;
+};
+
+/**
+ * Records the lifetime of the enclosing scope when tracing is started.
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category, const char* detail = 0)
+        : m_name(Trace::enabled() ? name : 0)
+        , m_category(category)
+        , m_detail(detail)
+        , m_begin(m_name ? TickClock::now() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (m_name)
+            Trace::record(m_name, m_category, m_detail, m_begin, TickClock::now());
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    const char* m_detail;
+    unsigned long long m_begin;
+
+    TraceSpan(const TraceSpan&);
+    TraceSpan& operator=(const TraceSpan&);
+};
+
+} // namespace webworks
+
+#endif /* TRACE_HPP_ */
@@ -0,0 +1,95 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <unicode/tzrule.h>
+#include <unicode/tztrans.h>
+#include <unicode/vtzone.h>
+#include "transition_table.hpp"
+
+namespace webworks {
+
+static const double kMillisPerDay = 86400000.0;
+
+// Milliseconds from the epoch to January 1st of the year, UTC, in the
+// proleptic Gregorian calendar.
+static UDate startOfYear(int year)
+{
+    long y = year - 1;
+    long days = 365 * y + y / 4 - y / 100 + y / 400 - 719162;
+    return days * kMillisPerDay;
+}
+
+TransitionTable::TransitionTable(const TimeZone& zone, int firstYear, int lastYear)
+    : m_end(startOfYear(lastYear + 1))
+{
+    UDate start = startOfYear(firstYear);
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t rawOffset, dstOffset;
+    zone.getOffset(start, false, rawOffset, dstOffset, status);
+    if (U_FAILURE(status)) {
+        // An empty table sends every query to ICU.
+        m_end = start;
+        return;
+    }
+
+    m_times.push_back(start);
+    m_rawOffsets.push_back(rawOffset);
+    m_dstOffsets.push_back(dstOffset);
+
+    // VTimeZone is a BasicTimeZone built from the id, which avoids casting
+    // whatever TimeZone subclass we were given.
+    UnicodeString id;
+    zone.getID(id);
+    std::auto_ptr<VTimeZone> vtz(VTimeZone::createVTimeZoneByID(id));
+    if (!vtz.get() || !vtz->hasSameRules(zone)) {
+        m_end = start;
+        m_times.clear();
+        m_rawOffsets.clear();
+        m_dstOffsets.clear();
+        return;
+    }
+
+    TimeZoneTransition transition;
+    UDate time = start;
+    while (vtz->getNextTransition(time, false, transition)) {
+        time = transition.getTime();
+        if (time >= m_end)
+            break;
+
+        const TimeZoneRule* to = transition.getTo();
+        if (!to) {
+            m_end = time;
+            break;
+        }
+
+        m_times.push_back(time);
+        m_rawOffsets.push_back(to->getRawOffset());
+        m_dstOffsets.push_back(to->getDSTSavings());
+    }
+}
+
+bool TransitionTable::lookup(UDate date, int32_t& rawOffset, int32_t& dstOffset) const
+{
+    if (m_times.empty() || !(date >= m_times.front() && date < m_end))
+        return false;
+
+    size_t i = std::upper_bound(m_times.begin(), m_times.end(), date) - m_times.begin() - 1;
+    rawOffset = m_rawOffsets[i];
+    dstOffset = m_dstOffsets[i];
+    return true;
+}
+
+} // namespace webworks
@@ -0,0 +1,53 @@
+/*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TRANSITION_TABLE_HPP_
+#define TRANSITION_TABLE_HPP_
+
+#include <vector>
+#include <unicode/timezone.h>
+
+U_NAMESPACE_USE
+
+namespace webworks {
+
+/**
+ * Raw and DST offsets of a zone between its transitions, for the years
+ * firstYear to lastYear inclusive.
+ *
+ * The transitions come from BasicTimeZone::getNextTransition, so a binary
+ * search over them gives the same answer as TimeZone::getOffset inside the
+ * window. Dates outside it are left to ICU.
+ */
+class TransitionTable {
+public:
+    TransitionTable(const TimeZone& zone, int firstYear, int lastYear);
+
+    // Offsets in milliseconds in effect at the UTC date, false if the date
+    // is outside the window.
+    bool lookup(UDate date, int32_t& rawOffset, int32_t& dstOffset) const;
+
+    size_t size() const { return m_times.size(); }
+
+private:
+    UDate m_end;
+    // m_times[0] is the start of the window, the other entries transitions.
+    std::vector<UDate> m_times;
+    std::vector<int32_t> m_rawOffsets;
+    std::vector<int32_t> m_dstOffsets;
+};
+
+} // namespace webworks
+
+#endif /* TRANSITION_TABLE_HPP_ */
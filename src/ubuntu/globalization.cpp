@@ -17,326 +17,236 @@
  *
 */
 
-#include <ctime> //TODO: switch to QTimeZone (QT 5.1)
-#include <unicode/decimfmt.h>
-#include <unicode/timezone.h>
-
 #include "globalization.h"
 
+// How long a time zone lookup is trusted before asking the host again.
+static const qint64 kZoneCheckInterval = 1000;
+
+// Bumped on QEvent::LocaleChange, every thread's LocaleState compares it
+// with the generation it was built for.
+static QAtomicInt s_localeGeneration;
+
+class Globalization::Task: public QRunnable {
+public:
+    Task(Globalization *owner, quint64 sequence, const Work &work):
+        m_owner(owner), m_sequence(sequence), m_work(work) {}
+
+    void run() override {
+        GlobalizationReply reply;
+        m_work(Globalization::localeState(), reply);
+        emit m_owner->replyReady(m_sequence, reply);
+    }
+
+private:
+    Globalization *m_owner;
+    quint64 m_sequence;
+    Work m_work;
+};
+
 Globalization::Globalization(Cordova *cordova):
-    CPlugin(cordova) {
+    CPlugin(cordova), m_engine(webworks::GlobalizationEngine::acquire(true)), m_threaded(false),
+    m_nextSequence(0), m_deliverSequence(0) {
+    qRegisterMetaType<GlobalizationReply>();
+    // Idle workers are kept, and with them their LocaleState.
+    m_pool.setExpiryTimeout(-1);
+    connect(this, &Globalization::replyReady, this, &Globalization::complete, Qt::QueuedConnection);
+
+    if (QCoreApplication::instance())
+        QCoreApplication::instance()->installEventFilter(this);
 }
 
-void Globalization::getPreferredLanguage(int scId, int ecId) {
-    Q_UNUSED(ecId)
+Globalization::~Globalization() {
+    m_pool.waitForDone();
+    webworks::GlobalizationEngine::release(m_engine);
+}
 
-    QLocale locale;
-    QString lang = QLocale::languageToString(locale.language());
-    QVariantMap obj;
-    obj.insert("value", lang);
-    this->cb(scId, obj);
+bool Globalization::eventFilter(QObject *watched, QEvent *event) {
+    if (event->type() == QEvent::LocaleChange)
+        s_localeGeneration.ref();
+    return CPlugin::eventFilter(watched, event);
 }
 
-void Globalization::getLocaleName(int scId, int ecId) {
-    Q_UNUSED(ecId)
+void Globalization::LocaleState::refresh() {
+    if (!zoneCheck.isValid() || zoneCheck.hasExpired(kZoneCheckInterval)) {
+        zoneId = QTimeZone::systemTimeZoneId();
+        zoneCheck.start();
+    }
 
-    QVariantMap obj;
-    obj.insert("value", QLocale().name());
-    this->cb(scId, obj);
-}
+    int current = s_localeGeneration.load();
+    QLocale system;
+    if (current == generation && system == locale)
+        return;
 
-void Globalization::getFirstDayOfWeek(int scId, int ecId) {
-    Q_UNUSED(ecId)
+    locale = system;
+    localeName = system.name().toStdString();
+    generation = current;
+}
 
-    QLocale locale;
+Globalization::LocaleState &Globalization::localeState() {
+    static QThreadStorage<LocaleState *> states;
+    if (!states.hasLocalData())
+        states.setLocalData(new LocaleState);
+    LocaleState *state = states.localData();
+    state->refresh();
+    return *state;
+}
 
-    int res;
-    if (locale.firstDayOfWeek() == Qt::Sunday) {
-        res = 1;
-    } else {
-        res = (2 - Qt::Monday) + locale.firstDayOfWeek();
+void Globalization::run(const Work &work) {
+    quint64 sequence = m_nextSequence++;
+    if (m_threaded) {
+        m_pool.start(new Task(this, sequence, work));
+        return;
     }
 
-    QVariantMap obj;
-    obj.insert("value", res);
-    this->cb(scId, obj);
+    GlobalizationReply reply;
+    work(localeState(), reply);
+    complete(sequence, reply);
 }
 
-void Globalization::isDayLightSavingsTime(int scId, int ecId, const QVariantMap &options) {
-    time_t time = options.find("time_t")->toLongLong() / 1000;
-    const tm *desc = std::localtime(&time);
-    if (desc->tm_isdst < 0) {
-        this->callback(ecId, QString("new GlobalizationError(%1, 'information is not available');").arg(Globalization::UNKNOWN_ERROR));
+void Globalization::complete(quint64 sequence, const GlobalizationReply &reply) {
+    if (sequence != m_deliverSequence) {
+        m_pending.insert(sequence, reply);
         return;
     }
-    this->callback(scId, QString("{dst:%1}").arg(desc->tm_isdst > 0 ? "true" : "false"));
-}
 
-QLocale::FormatType translateFormat(Globalization::Format formatLength) {
-    QLocale::FormatType format = QLocale::ShortFormat;
-    switch (formatLength) {
-    case Globalization::FORMAT_FULL:
-    case Globalization::FORMAT_LONG:
-        format = QLocale::ShortFormat; // TODO: Qt cant parse string produced with QLocale::LongFormat;
-        break;
-    case Globalization::FORMAT_MEDIUM:
-        format = QLocale::ShortFormat;
-        break;
-    case Globalization::FORMAT_SHORT:
-        format = QLocale::NarrowFormat;
-        break;
+    ++m_deliverSequence;
+    deliver(reply);
+
+    QMap<quint64, GlobalizationReply>::iterator next = m_pending.begin();
+    while (next != m_pending.end() && next.key() == m_deliverSequence) {
+        GlobalizationReply pending = next.value();
+        m_pending.erase(next);
+        ++m_deliverSequence;
+        deliver(pending);
+        next = m_pending.begin();
     }
-    return format;
 }
 
-void Globalization::dateToString(int scId, int ecId, const QVariantMap &options) {
-    time_t time = options.find("time_t")->toLongLong() / 1000;
+void Globalization::deliver(const GlobalizationReply &reply) {
+    this->cb(reply.id, reply.payload);
+}
+
+// The engine's arguments with the host's locale and time zone added to the
+// options, unless the caller named its own. Options that are not an object
+// are left for the engine to reject.
+static std::string request(const std::string &localeName, const QByteArray &zoneId, const QVariantMap &args) {
+    QJsonObject root = QJsonObject::fromVariantMap(args);
+    QJsonValue given = root.value("options");
+    if (given.isUndefined() || given.isNull() || given.isObject()) {
+        QJsonObject options = given.toObject();
+        if (!options.contains("locale"))
+            options.insert("locale", QString::fromStdString(localeName));
+        if (!options.contains("timeZone") && !zoneId.isEmpty())
+            options.insert("timeZone", QString::fromLatin1(zoneId));
+        root.insert("options", options);
+    }
 
-    Globalization::Format formatLength = static_cast<Globalization::Format>(options.find("formatLength")->toInt());
-    Globalization::Selector selector = static_cast<Globalization::Selector>(options.find("selector")->toInt());
+    QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    return std::string(json.constData(), json.size());
+}
 
-    QLocale::FormatType format = translateFormat(formatLength);
-    if (time < 0) {
-        this->callback(ecId, QString("new GlobalizationError(%1, 'unsupported operation');").arg(Globalization::FORMATTING_ERROR));
+// Delivers the engine's {"result": ...} or {"error": {code, message}}.
+static void respond(const std::string &response, int scId, int ecId, const char *key, GlobalizationReply &reply) {
+    QJsonObject root = QJsonDocument::fromJson(QByteArray(response.data(), response.size())).object();
+    if (root.contains("error")) {
+        QJsonObject error = root.value("error").toObject();
+        reply.failure(ecId, error.value("code").toInt(), error.value("message").toString());
         return;
     }
 
-    QLocale locale;
-    QString res;
-    QDateTime dateTime = QDateTime::fromTime_t((uint)time);
-    switch (selector) {
-    case SELECTOR_ALL:
-        res = locale.toString(dateTime,format);
-        break;
-    case SELECTOR_TIME:
-        res = locale.toString(dateTime.time(), format);
-        break;
-    case SELECTOR_DATE:
-        res = locale.toString(dateTime.date(), format);
-        break;
+    QVariant result = root.value("result").toVariant();
+    if (!key) {
+        reply.success(scId, result.toMap());
+        return;
     }
+
     QVariantMap obj;
-    obj.insert("value", res);
-    this->cb(scId, obj);
+    obj.insert(key, result);
+    reply.success(scId, obj);
 }
 
-void Globalization::stringToDate(int scId, int ecId, const QVariantMap &options) {
-    QString dateString = options.find("dateString")->toString();
-    Globalization::Format formatLength = static_cast<Globalization::Format>(options.find("formatLength")->toInt());
-    Globalization::Selector selector = static_cast<Globalization::Selector>(options.find("selector")->toInt());
-
-    QLocale::FormatType format = translateFormat(formatLength);
-    QLocale locale;
-    bool valid(true);
-    int year(0), month(0), day(0), hour(0), minute(0), second(0), millisecond(0);
-    switch (selector) {
-    case SELECTOR_ALL:
-        {
-            QDateTime dateTime = locale.toDateTime(dateString, format);
-            valid = dateTime.isValid();
-            QTime time = dateTime.time();
-            hour = time.hour(); minute = time.minute(); second = time.second(); millisecond = time.msec();
-            QDate date = dateTime.date();
-            year = date.year(); month = date.month(); day = date.day();
-        }
-        break;
-    case SELECTOR_TIME:
-        {
-            QTime time = locale.toTime(dateString, format);
-            valid = time.isValid();
-            hour = time.hour(); minute = time.minute(); second = time.second(); millisecond = time.msec();
-        }
-        break;
-    case SELECTOR_DATE:
-        {
-            QDate date = locale.toDate(dateString, format);
-            valid = date.isValid();
-            year = date.year(); month = date.month(); day = date.day();
-        }
-        break;
-    }
-    if ((format == QLocale::NarrowFormat || format == QLocale::ShortFormat) && year < 2000 && year > 1900) {
-        year += 100;
-    }
-    if (!valid) {
-        this->callback(ecId, QString("new GlobalizationError(%1, 'parsing error')").arg(Globalization::PARSING_ERROR));
-    } else {
-        QVariantMap obj;
-        obj.insert("year", year);
-        obj.insert("month", month - 1);
-        obj.insert("day", day);
-        obj.insert("hour", hour);
-        obj.insert("minute", minute);
-        obj.insert("second", second);
-        obj.insert("millisecond", millisecond);
-        this->cb(scId, obj);
-    }
+void Globalization::call(int scId, int ecId, const QVariantMap &args, const Operation &operation, const char *key) {
+    webworks::GlobalizationEngine *engine = m_engine;
+    run([scId, ecId, args, operation, key, engine](const LocaleState &state, GlobalizationReply &reply) {
+        respond(operation(*engine, request(state.localeName, state.zoneId, args)), scId, ecId, key, reply);
+    });
 }
 
-void Globalization::getDateNames(int scId, int ecId, const QVariantMap &options) {
+void Globalization::setThreaded(int scId, int ecId, bool threaded) {
     Q_UNUSED(ecId)
 
-    int type = options.find("type")->toInt();
-    int item = options.find("item")->toInt();
-
-    QLocale::FormatType format;
-    if (type == FORMAT_SHORT)
-        format = QLocale::ShortFormat;
-    else
-        format = QLocale::LongFormat;
-    QLocale locale;
-    QList<QString> res;
-    if (item == REQUEST_DAY_NAMES) {
-        for (int i = 1; i <= 7; i++) {
-            res.append(locale.dayName(i, format));
-        }
-    } else { //REQUEST_MONTH_NAMES
-        for (int i = 1; i <= 12; i++) {
-            res.append(locale.monthName(i, format));
-        }
-    }
-
-    QString result;
-    for (QList<QString>::iterator it = res.begin(); it != res.end(); it++) {
-        result += QString("'%1',").arg(*it);
-    }
-    this->callback(scId, QString("{ value: [ %1 ]}").arg(result));
+    m_threaded = threaded;
+    run([scId, threaded](const LocaleState &, GlobalizationReply &reply) {
+        reply.value(scId, threaded);
+    });
 }
 
-template<class T>
-static QString format(T number, Globalization::NumberType type) {
-    QString res;
-    QLocale locale;
-    switch (type) {
-    case Globalization::DECIMAL:
-        res = locale.toString(number);
-        break;
-    case Globalization::PERCENT:
-        res = locale.toString(number) + locale.percent();
-        break;
-    case Globalization::CURRENCY:
-        res = locale.toCurrencyString(number);
-        break;
-    };
-    return res;
+void Globalization::getPreferredLanguage(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, [](webworks::GlobalizationEngine &engine, const std::string &json) {
+        return engine.getPreferredLanguage(json);
+    }, "value");
 }
 
-void Globalization::numberToString(int scId, int ecId, const QVariantMap &options) {
-    Q_UNUSED(ecId)
-
-    bool isInt = options.find("isInt")->toBool();
-    NumberType type = static_cast<NumberType>(options.find("type")->toBool());
-
-    QString res;
-    if (isInt) {
-        long long number = options.find("number")->toLongLong();
-        res = format(number, type);
-    } else {
-        double number = options.find("number")->toDouble();
-        res = format(number, type);
-    }
-    this->callback(scId, QString("{ value: '%1' }").arg(res));
+void Globalization::getLocaleName(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, [](webworks::GlobalizationEngine &engine, const std::string &json) {
+        return engine.getLocaleName(json);
+    }, "value");
 }
 
-void Globalization::stringToNumber(int scId, int ecId, int type, QString string) {
-    switch ((NumberType)type) {
-    case Globalization::DECIMAL:
-        string = string.remove(QLocale().groupSeparator());
-        break;
-    case Globalization::PERCENT:
-        string = string.remove(QLocale().percent()).remove(QLocale().groupSeparator());
-        break;
-    case Globalization::CURRENCY:
-        string = string.remove(QLocale().currencySymbol()).remove(QLocale().groupSeparator());
-        break;
-    };
-    bool ok;
-    double res = QLocale().toDouble(string, &ok);
-    if (ok)
-        this->callback(scId, QString("{ value: %1 }").arg(res));
-    else
-        this->callback(ecId, QString("new GlobalizationError(%1, 'parsing error')").arg(Globalization::PARSING_ERROR));
+void Globalization::getFirstDayOfWeek(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::getFirstDayOfWeek, "value");
 }
 
-static QString ustr2qstr(UnicodeString &ustr) {
-    std::string res;
-    ustr.toUTF8String(res);
+void Globalization::isDayLightSavingsTime(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::isDayLightSavingsTime, "dst");
+}
 
-    return QString(res.c_str());
+void Globalization::dateToString(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::dateToString, "value");
 }
 
-void Globalization::getNumberPattern(int scId, int ecId, int type) {
-    Q_UNUSED(ecId);
-    UErrorCode status = U_ZERO_ERROR;
-    icu::DecimalFormat icu(status);
+void Globalization::stringToDate(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::stringToDate, NULL);
+}
 
-    icu::UnicodeString pattern;
-    icu.toPattern(pattern);
+void Globalization::getDatePattern(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::getDatePattern, NULL);
+}
 
-    QLocale locale;
-    QVariantMap obj;
+void Globalization::getDateNames(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::getDateNames, "value");
+}
 
-    obj.insert("pattern", ustr2qstr(pattern));
-
-    switch ((NumberType)type) {
-    case Globalization::DECIMAL:
-        obj.insert("symbol", "");
-        break;
-    case Globalization::PERCENT:
-        obj.insert("symbol", QString(locale.percent()));
-        break;
-    case Globalization::CURRENCY:
-        obj.insert("symbol", QString(locale.currencySymbol()));
-        break;
-    };
-
-    obj.insert("fraction", icu.getMaximumFractionDigits());
-    obj.insert("rounding", icu.getRoundingIncrement());
-    obj.insert("positive", QString(locale.positiveSign()));
-    obj.insert("negative", QString(locale.negativeSign()));
-    obj.insert("decimal", QString(locale.decimalPoint()));
-    obj.insert("grouping", QString(locale.groupSeparator()));
-
-    this->cb(scId, obj);
+void Globalization::numberToString(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::numberToString, "value");
 }
 
-static bool inDayLightSavingsTime() {
-    time_t now;
+void Globalization::stringToNumber(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::stringToNumber, "value");
+}
 
-    time(&now);
+void Globalization::getNumberPattern(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::getNumberPattern, NULL);
+}
 
-    const tm *desc = std::localtime(&now);
+void Globalization::getCurrencyPattern(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, &webworks::GlobalizationEngine::getCurrencyPattern, NULL);
+}
 
-    return desc->tm_isdst > 0;
+void Globalization::dateToStringBatch(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, [](webworks::GlobalizationEngine &engine, const std::string &json) {
+        return engine.dateToStringBatch(json);
+    }, NULL);
 }
 
-void Globalization::getDatePattern(int scId, int ecId, int formatLength, int selector) {
-    Q_UNUSED(ecId);
-
-    QLocale locale;
-    QVariantMap res;
-    QLocale::FormatType format = translateFormat((Format)formatLength);
-
-    switch ((Selector)selector) {
-    case Selector::SELECTOR_TIME:
-        res.insert("pattern", locale.timeFormat(format));
-        break;
-    case Selector::SELECTOR_DATE:
-        res.insert("pattern", locale.dateFormat(format));
-        break;
-    case Selector::SELECTOR_ALL:
-        res.insert("pattern", locale.dateTimeFormat(format));
-        break;
-    };
-
-    UnicodeString result;
-    QSharedPointer<TimeZone> timezone = QSharedPointer<TimeZone>(TimeZone::createDefault());
-    timezone->getDisplayName(inDayLightSavingsTime(), TimeZone::SHORT, result);
-
-    res.insert("timezone", ustr2qstr(result));
-    res.insert("utc_offset", timezone->getRawOffset() / 1000 + timezone->getDSTSavings() / 1000);
-    res.insert("dst_offset", timezone->getDSTSavings() / 1000);
-
-    this->cb(scId, res);
+void Globalization::numberToStringBatch(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, [](webworks::GlobalizationEngine &engine, const std::string &json) {
+        return engine.numberToStringBatch(json);
+    }, NULL);
 }
 
+void Globalization::stringToNumberBatch(int scId, int ecId, const QVariantMap &args) {
+    call(scId, ecId, args, [](webworks::GlobalizationEngine &engine, const std::string &json) {
+        return engine.stringToNumberBatch(json);
+    }, NULL);
+}
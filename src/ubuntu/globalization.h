@@ -19,46 +19,59 @@
 #ifndef GLOBALIZATION_H_SVO2013
 #define GLOBALIZATION_H_SVO2013
 
+#include <functional>
+#include <string>
 #include <QtCore>
 #include <QLocale>
+#include <QThreadPool>
+#include <QTimeZone>
 
 #include <cplugin.h>
 
-class Globalization: public CPlugin {
-    Q_OBJECT
-    enum GlobalizationError {
-        UNKNOWN_ERROR = 0,
-        FORMATTING_ERROR = 1,
-        PARSING_ERROR = 2,
-        PATTERN_ERROR = 3
-    };
+#include "globalization_engine.hpp"
 
-    enum Selector {
-        SELECTOR_DATE = 0,
-        SELECTOR_TIME = 1,
-        SELECTOR_ALL = 2
-    };
+// The result of one slot call, handed from the thread that computed it to
+// the Qt thread that delivers it through cb(). Results are always plain
+// maps, serialized to JSON by CPlugin, never script for the WebView to
+// eval.
+struct GlobalizationReply {
+    GlobalizationReply(): id(-1) {}
 
-    enum Format {
-        FORMAT_SHORT = 0,
-        FORMAT_MEDIUM = 1,
-        FORMAT_LONG = 2,
-        FORMAT_FULL = 3
-    };
+    void success(int scId, const QVariantMap &obj) {
+        id = scId;
+        payload = obj;
+    }
 
-    enum {
-        REQUEST_DAY_NAMES = 0,
-        REQUEST_MONTH_NAMES = 1
-    };
+    // The common { value: ... } result.
+    void value(int scId, const QVariant &result) {
+        QVariantMap obj;
+        obj.insert("value", result);
+        success(scId, obj);
+    }
 
-    enum NumberType {
-        DECIMAL,
-        PERCENT,
-        CURRENCY
-    };
+    // Rebuilt into a GlobalizationError by www/ubuntu/globalization.js.
+    void failure(int ecId, int code, const QString &message) {
+        QVariantMap obj;
+        obj.insert("code", code);
+        obj.insert("message", message);
+        success(ecId, obj);
+    }
+
+    int id;
+    QVariantMap payload;
+};
+
+Q_DECLARE_METATYPE(GlobalizationReply)
+
+// A thin adapter over the shared webworks::GlobalizationEngine: the slots
+// take the same argument objects as the engine, add the host's locale and
+// time zone to their options and hand the engine's result to JavaScript.
+class Globalization: public CPlugin {
+    Q_OBJECT
 
 public:
     explicit Globalization(Cordova *cordova);
+    ~Globalization();
 
     virtual const QString fullName() override {
         return Globalization::fullID();
@@ -73,21 +86,77 @@ public:
     }
 
 public slots:
-    void getPreferredLanguage(int scId, int ecId);
-    void getLocaleName(int scId, int ecId);
-    void getFirstDayOfWeek(int scId, int ecId);
-    void isDayLightSavingsTime(int scId, int ecId, const QVariantMap &options);
-    void dateToString(int scId, int ecId, const QVariantMap &options);
-    void stringToDate(int scId, int ecId, const QVariantMap &options);
-
-    void getDateNames(int scId, int ecId, const QVariantMap &options);
-    void numberToString(int scId, int ecId, const QVariantMap &options);
-    void stringToNumber(int scId, int ecId, int type, QString string);
-    void getNumberPattern(int scId, int ecId, int type);
-    void getDatePattern(int scId, int ecId, int formatLength, int selector);
+    void getPreferredLanguage(int scId, int ecId, const QVariantMap &args);
+    void getLocaleName(int scId, int ecId, const QVariantMap &args);
+    void getFirstDayOfWeek(int scId, int ecId, const QVariantMap &args);
+    void isDayLightSavingsTime(int scId, int ecId, const QVariantMap &args);
+    void dateToString(int scId, int ecId, const QVariantMap &args);
+    void stringToDate(int scId, int ecId, const QVariantMap &args);
+    void getDatePattern(int scId, int ecId, const QVariantMap &args);
+    void getDateNames(int scId, int ecId, const QVariantMap &args);
+    void numberToString(int scId, int ecId, const QVariantMap &args);
+    void stringToNumber(int scId, int ecId, const QVariantMap &args);
+    void getNumberPattern(int scId, int ecId, const QVariantMap &args);
+    void getCurrencyPattern(int scId, int ecId, const QVariantMap &args);
+
+    // Batch forms of dateToString, numberToString and stringToNumber. The
+    // result is { value: [...], errors: [...] }, with null for each element
+    // that failed and an { index, code, message } entry for it in errors.
+    void dateToStringBatch(int scId, int ecId, const QVariantMap &args);
+    void numberToStringBatch(int scId, int ecId, const QVariantMap &args);
+    void stringToNumberBatch(int scId, int ecId, const QVariantMap &args);
+
+    // With threaded set, the slots above run on a worker pool and their
+    // results are delivered on this object's thread in call order.
+    void setThreaded(int scId, int ecId, bool threaded);
+
+signals:
+    void replyReady(quint64 sequence, const GlobalizationReply &reply);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void complete(quint64 sequence, const GlobalizationReply &reply);
+
 private:
-    friend QLocale::FormatType translateFormat(Globalization::Format formatLength);
-    template<class T> friend QString format(T number, Globalization::NumberType type);
+    // The host's locale and time zone, kept per thread and read again when
+    // the application reports a locale change or the default locale
+    // changes. The host time zone is checked again at most once a second.
+    struct LocaleState {
+        LocaleState(): generation(-1) {}
+        void refresh();
+
+        int generation;
+        QElapsedTimer zoneCheck;
+        QLocale locale;
+        std::string localeName;
+        QByteArray zoneId;
+    };
+
+    typedef std::function<void(const LocaleState &state, GlobalizationReply &reply)> Work;
+    typedef std::function<std::string(webworks::GlobalizationEngine &engine, const std::string &args)> Operation;
+
+    class Task;
+
+    static LocaleState &localeState();
+
+    // Runs operation with args and the host's locale and time zone. With
+    // key set the result is delivered as { key: result }, otherwise the
+    // result is an object and delivered as it is.
+    void call(int scId, int ecId, const QVariantMap &args, const Operation &operation, const char *key);
+
+    void run(const Work &work);
+    void deliver(const GlobalizationReply &reply);
+
+    webworks::GlobalizationEngine *m_engine;
+    bool m_threaded;
+    QThreadPool m_pool;
+    // Replies are numbered as calls arrive, and those that finish early
+    // wait in m_pending until every earlier one has been delivered.
+    quint64 m_nextSequence;
+    quint64 m_deliverSequence;
+    QMap<quint64, GlobalizationReply> m_pending;
 };
 
 #endif
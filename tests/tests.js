@@ -26,6 +26,8 @@ exports.defineAutoTests = function () {
     var isWindowsPhone = cordova.platformId === 'windowsphone';
     var isWindows = (cordova.platformId === 'windows') || (cordova.platformId === 'windows8');
     var isBrowser = cordova.platformId === 'browser';
+    var isUbuntu = cordova.platformId === 'ubuntu';
+    var isBlackBerry10 = cordova.platformId === 'blackberry10';
 
     var fail = function (done) {
         expect(true).toBe(false);
@@ -228,6 +230,16 @@ exports.defineAutoTests = function () {
                     navigator.globalization.stringToDate(a.value, win, fail.bind(null, done), { formatLength: 'full', selector: 'date' });
                 }, fail.bind(null, done), { formatLength: 'full', selector: 'date' });
             });
+            it('globalization.spec.16 stringToDate of an afternoon time should report the hour from 0 to 23', function (done) {
+                navigator.globalization.dateToString(new Date(2014, 0, 1, 15, 45), function (a) {
+                    navigator.globalization.stringToDate(a.value, function (b) {
+                        checkStringToDate(b);
+                        expect(b.hour).toBe(15);
+                        expect(b.minute).toBe(45);
+                        done();
+                    }, fail.bind(null, done));
+                }, fail.bind(null, done));
+            });
             it('globalization.spec.15 stringToDate using invalid date, error callback should be called with a GlobalizationError object', function (done) {
                 navigator.globalization.stringToDate('notADate', fail.bind(null, done), function (a) {
                     expect(a).toBeDefined();
@@ -561,5 +573,204 @@ exports.defineAutoTests = function () {
                 }, fail.bind(null, done));
             });
         });
+
+        describe('setThreaded', function () {
+            it('globalization.spec.42 threaded calls should deliver their results in call order', function (done) {
+                // only the ubuntu platform has a threaded execution mode
+                if (!isUbuntu) {
+                    pending();
+                }
+                var calls = 300;
+                var delivered = [];
+                var finish = function () {
+                    for (var i = 0; i < calls; i++) {
+                        expect(delivered[i]).toBe(i);
+                    }
+                    navigator.globalization.setThreaded(false, function () {
+                        done();
+                    }, fail.bind(null, done));
+                };
+                var record = function (id) {
+                    return function () {
+                        delivered.push(id);
+                        if (delivered.length === calls) {
+                            finish();
+                        }
+                    };
+                };
+
+                navigator.globalization.setThreaded(true, function () {
+                    for (var i = 0; i < calls; i++) {
+                        switch (i % 4) {
+                        case 0:
+                            navigator.globalization.dateToString(new Date(i * 86400000), record(i), record(i));
+                            break;
+                        case 1:
+                            navigator.globalization.getDatePattern(record(i), record(i), { formatLength: 'full' });
+                            break;
+                        case 2:
+                            navigator.globalization.numberToString(i * 1.5, record(i), record(i));
+                            break;
+                        default:
+                            navigator.globalization.stringToNumber('x' + i, record(i), record(i));
+                            break;
+                        }
+                    }
+                }, fail.bind(null, done));
+            });
+        });
+
+        describe('batch calls', function () {
+            it('globalization.spec.43 stringToNumberBatch should report failed elements without failing the batch', function (done) {
+                // only the ubuntu and blackberry10 platforms have batch calls
+                if (!isUbuntu && !isBlackBerry10) {
+                    pending();
+                }
+                navigator.globalization.numberToStringBatch([1, 2.5, 1000], function (formatted) {
+                    expect(formatted.value.length).toBe(3);
+                    expect(formatted.errors.length).toBe(0);
+
+                    var strings = formatted.value.concat(['not a number']);
+                    navigator.globalization.stringToNumberBatch(strings, function (a) {
+                        expect(a.value.slice(0, 3)).toEqual([1, 2.5, 1000]);
+                        expect(a.value[3]).toBe(null);
+                        expect(a.errors.length).toBe(1);
+                        expect(a.errors[0].index).toBe(3);
+                        expect(a.errors[0].code).toBe(GlobalizationError.PARSING_ERROR);
+                        done();
+                    }, fail.bind(null, done));
+                }, fail.bind(null, done));
+            });
+            it('globalization.spec.44 numberToStringBatch should format a packed Float64Array like the same numbers in an Array', function (done) {
+                // only the blackberry10 platform takes packed input
+                if (!isBlackBerry10) {
+                    pending();
+                }
+                var numbers = [0, -1.25, 3.5e10, 1 / 3];
+                navigator.globalization.numberToStringBatch(numbers, function (expected) {
+                    navigator.globalization.numberToStringBatch(new Float64Array(numbers), function (a) {
+                        expect(a.value).toEqual(expected.value);
+                        expect(a.errors.length).toBe(0);
+                        done();
+                    }, fail.bind(null, done));
+                }, fail.bind(null, done));
+            });
+            it('globalization.spec.45 stringToNumberBatch with chunkSize should deliver every chunk in order and then done', function (done) {
+                // only the blackberry10 platform streams batch results
+                if (!isBlackBerry10) {
+                    pending();
+                }
+                var strings = ['1', '2', '3', 'x', '5', '6', '7', '8', '9', '10'];
+                var offsets = [];
+                var values = [];
+                var errors = [];
+                navigator.globalization.stringToNumberBatch(strings, function (a) {
+                    if (!a.done) {
+                        expect(a.offset).toBe(values.length);
+                        expect(a.value.length).toBeLessThan(5);
+                        offsets.push(a.offset);
+                        values = values.concat(a.value);
+                        errors = errors.concat(a.errors);
+                        return;
+                    }
+                    expect(offsets).toEqual([0, 4, 8]);
+                    expect(a.offset).toBe(strings.length);
+                    expect(a.value.length).toBe(0);
+                    expect(values).toEqual([1, 2, 3, null, 5, 6, 7, 8, 9, 10]);
+                    expect(errors.length).toBe(1);
+                    expect(errors[0].index).toBe(3);
+                    done();
+                }, fail.bind(null, done), { chunkSize: 4 });
+            });
+        });
+
+        describe('locale option', function () {
+            it('globalization.spec.46 every method should accept an options object with only a locale', function (done) {
+                // only the blackberry10 and ubuntu platforms take a per-call locale
+                if (!isBlackBerry10 && !isUbuntu) {
+                    pending();
+                }
+                var g = navigator.globalization;
+                var options = { locale: 'de-CH' };
+                var date = new Date(2014, 0, 1, 12, 0, 0);
+                var steps = [
+                    function (next) {
+                        g.getPreferredLanguage(function (a) {
+                            expect(a.value).toBe('de-CH');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getLocaleName(function (a) {
+                            expect(a.value).toBe('de-CH');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.dateToString(date, function (a) {
+                            g.stringToDate(a.value, function (b) {
+                                expect(b.year).toBe(2014);
+                                expect(b.month).toBe(0);
+                                expect(b.day).toBe(1);
+                                next();
+                            }, fail.bind(null, done), options);
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getDatePattern(function (a) {
+                            expect(typeof a.pattern).toBe('string');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getDateNames(function (a) {
+                            expect(a.value[0]).toBe('Januar');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.isDayLightSavingsTime(date, function (a) {
+                            expect(typeof a.dst).toBe('boolean');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getFirstDayOfWeek(function (a) {
+                            expect(a.value).toBe(2);
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.numberToString(1234.5, function (a) {
+                            expect(a.value).not.toBe('1,234.5');
+                            g.stringToNumber(a.value, function (b) {
+                                expect(b.value).toBe(1234.5);
+                                next();
+                            }, fail.bind(null, done), options);
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getNumberPattern(function (a) {
+                            expect(typeof a.pattern).toBe('string');
+                            next();
+                        }, fail.bind(null, done), options);
+                    },
+                    function (next) {
+                        g.getCurrencyPattern('CHF', function (a) {
+                            expect(a.code).toBe('CHF');
+                            next();
+                        }, fail.bind(null, done), options);
+                    }
+                ];
+                var run = function (i) {
+                    if (i === steps.length) {
+                        done();
+                    } else {
+                        steps[i](run.bind(null, i + 1));
+                    }
+                };
+                run(0);
+            });
+        });
     });
 };
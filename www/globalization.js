@@ -22,6 +22,44 @@
 var argscheck = require('cordova/argscheck');
 var exec = require('cordova/exec');
 
+function isFloat64Array (values) {
+    return typeof Float64Array !== 'undefined' && values instanceof Float64Array;
+}
+
+// A Float64Array goes as base64 of its bytes, little-endian on every
+// platform Cordova runs on.
+function packedArgs (key, values, options) {
+    var bytes = new Uint8Array(values.buffer, values.byteOffset, values.byteLength);
+    var binary = '';
+    for (var i = 0; i < bytes.length; i += 0x8000) {
+        binary += String.fromCharCode.apply(null, bytes.subarray(i, i + 0x8000));
+    }
+
+    var args = {'packing': 'float64', 'options': options};
+    args[key] = btoa(binary);
+    return args;
+}
+
+// A chunkSize option streams the batch command through streamBatch. It
+// only picks the delivery, so the native command gets the options without it.
+function execBatch (successCB, failureCB, action, args, options) {
+    if (options && options.chunkSize !== undefined) {
+        var batchOptions = {};
+        for (var key in options) {
+            if (key !== 'chunkSize') {
+                batchOptions[key] = options[key];
+            }
+        }
+        args.options = batchOptions;
+    }
+
+    if (options && options.chunkSize) {
+        exec(successCB, failureCB, 'Globalization', 'streamBatch', [action, options.chunkSize, args]);
+    } else {
+        exec(successCB, failureCB, 'Globalization', action, [args]);
+    }
+}
+
 var globalization = {
 
 /**
@@ -32,6 +70,8 @@ var globalization = {
 *
 * @param {Function} successCB
 * @param {Function} errorCB
+* @param {Object} options {optional}
+*            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
 *
 * @return Object.value {String}: The language identifier
 *
@@ -41,9 +81,9 @@ var globalization = {
 *    globalization.getPreferredLanguage(function (language) {alert('language:' + language.value + '\n');},
 *                                function () {});
 */
-    getPreferredLanguage: function (successCB, failureCB) {
-        argscheck.checkArgs('fF', 'Globalization.getPreferredLanguage', arguments);
-        exec(successCB, failureCB, 'Globalization', 'getPreferredLanguage', []);
+    getPreferredLanguage: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getPreferredLanguage', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getPreferredLanguage', options ? [{'options': options}] : []);
     },
 
     /**
@@ -54,6 +94,8 @@ var globalization = {
     *
     * @param {Function} successCB
     * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return Object.value {String}: The locale identifier
     *
@@ -63,9 +105,9 @@ var globalization = {
     *    globalization.getLocaleName(function (locale) {alert('locale:' + locale.value + '\n');},
     *                                function () {});
     */
-    getLocaleName: function (successCB, failureCB) {
-        argscheck.checkArgs('fF', 'Globalization.getLocaleName', arguments);
-        exec(successCB, failureCB, 'Globalization', 'getLocaleName', []);
+    getLocaleName: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getLocaleName', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getLocaleName', options ? [{'options': options}] : []);
     },
 
     /**
@@ -82,6 +124,8 @@ var globalization = {
     * @param {Object} options {optional}
     *            formatLength {String}: 'short', 'medium', 'long', or 'full'
     *            selector {String}: 'date', 'time', or 'date and time'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
+    *            timeZone {String}: IANA id such as 'Europe/Paris', instead of the client's time zone (BlackBerry 10)
     *
     * @return Object.value {String}: The localized date string
     *
@@ -114,6 +158,8 @@ var globalization = {
     * @param {Object} options {optional}
     *            formatLength {String}: 'short', 'medium', 'long', or 'full'
     *            selector {String}: 'date', 'time', or 'date and time'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
+    *            timeZone {String}: IANA id such as 'Europe/Paris', instead of the client's time zone (BlackBerry 10)
     *
     * @return    Object.year {Number}: The four digit year
     *            Object.month {Number}: The month from (0 - 11)
@@ -152,6 +198,8 @@ var globalization = {
     * @param {Object} options {optional}
     *            formatLength {String}: 'short', 'medium', 'long', or 'full'
     *            selector {String}: 'date', 'time', or 'date and time'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
+    *            timeZone {String}: IANA id such as 'Europe/Paris', instead of the client's time zone (BlackBerry 10)
     *
     * @return    Object.pattern {String}: The date and time pattern for formatting and parsing dates.
     *                                    The patterns follow Unicode Technical Standard #35
@@ -189,6 +237,7 @@ var globalization = {
     * @param {Object} options {optional}
     *            type {String}: 'narrow' or 'wide'
     *            item {String}: 'months', or 'days'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return Object.value {Array{String}}: The array of names starting from either
     *                                        the first month in the year or the
@@ -215,6 +264,8 @@ var globalization = {
     * @param {Date} date
     * @param {Function} successCB
     * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            timeZone {String}: IANA id such as 'Europe/Paris', instead of the client's time zone (BlackBerry 10)
     *
     * @return Object.dst {Boolean}: The value "true" indicates that daylight savings time is
     *                                in effect for the given date and "false" indicate that it is not.
@@ -226,10 +277,10 @@ var globalization = {
     *                function (date) {alert('dst:' + date.dst + '\n');}
     *                function () {});
     */
-    isDayLightSavingsTime: function (date, successCB, failureCB) {
-        argscheck.checkArgs('dfF', 'Globalization.isDayLightSavingsTime', arguments);
+    isDayLightSavingsTime: function (date, successCB, failureCB, options) {
+        argscheck.checkArgs('dfFO', 'Globalization.isDayLightSavingsTime', arguments);
         var dateValue = date.valueOf();
-        exec(successCB, failureCB, 'Globalization', 'isDayLightSavingsTime', [{'date': dateValue}]);
+        exec(successCB, failureCB, 'Globalization', 'isDayLightSavingsTime', [{'date': dateValue, 'options': options}]);
     },
 
     /**
@@ -240,6 +291,8 @@ var globalization = {
     *
     * @param {Function} successCB
     * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return Object.value {Number}: The number of the first day of the week.
     *
@@ -250,9 +303,9 @@ var globalization = {
     *                { alert('Day:' + day.value + '\n');},
     *                function () {});
     */
-    getFirstDayOfWeek: function (successCB, failureCB) {
-        argscheck.checkArgs('fF', 'Globalization.getFirstDayOfWeek', arguments);
-        exec(successCB, failureCB, 'Globalization', 'getFirstDayOfWeek', []);
+    getFirstDayOfWeek: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getFirstDayOfWeek', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getFirstDayOfWeek', [{'options': options}]);
     },
 
     /**
@@ -267,6 +320,7 @@ var globalization = {
     * @param {Function} errorCB
     * @param {Object} options {optional}
     *            type {String}: 'decimal', "percent", or 'currency'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return Object.value {String}: The formatted number string.
     *
@@ -296,6 +350,7 @@ var globalization = {
     * @param {Function} errorCB
     * @param {Object} options {optional}
     *            type {String}: 'decimal', "percent", or 'currency'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return Object.value {Number}: The parsed number.
     *
@@ -322,6 +377,7 @@ var globalization = {
     * @param {Function} errorCB
     * @param {Object} options {optional}
     *            type {String}: 'decimal', "percent", or 'currency'
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return    Object.pattern {String}: The number pattern for formatting and parsing numbers.
     *                                    The patterns follow Unicode Technical Standard #35.
@@ -357,6 +413,8 @@ var globalization = {
     * @param {String} currencyCode
     * @param {Function} successCB
     * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            locale {String}: BCP 47 tag such as 'de-CH', instead of the client's locale (BlackBerry 10 and Ubuntu)
     *
     * @return    Object.pattern {String}: The currency pattern for formatting and parsing currency values.
     *                                    The patterns follow Unicode Technical Standard #35
@@ -375,9 +433,245 @@ var globalization = {
     *                function (currency) {alert('Pattern:' + currency.pattern + '\n');}
     *                function () {});
     */
-    getCurrencyPattern: function (currencyCode, successCB, failureCB) {
-        argscheck.checkArgs('sfF', 'Globalization.getCurrencyPattern', arguments);
-        exec(successCB, failureCB, 'Globalization', 'getCurrencyPattern', [{'currencyCode': currencyCode}]);
+    getCurrencyPattern: function (currencyCode, successCB, failureCB, options) {
+        argscheck.checkArgs('sfFO', 'Globalization.getCurrencyPattern', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getCurrencyPattern', [{'currencyCode': currencyCode, 'options': options}]);
+    },
+
+    /**
+    * Formats an array of dates with one set of options. Supported on BlackBerry 10 and
+    * Ubuntu. On BlackBerry 10 the dates may also be a Float64Array of milliseconds since
+    * the epoch, which reaches the native code packed instead of as JSON numbers.
+    *
+    * @param {Array|Float64Array} dates
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            formatLength {String}: 'short', 'medium', 'long', or 'full'
+    *            selector {String}: 'date', 'time', or 'date and time'
+    *            chunkSize {Number}: BlackBerry 10 only, streams the results, see below
+    *
+    * @return Object.value {Array}: The formatted dates, null where an element failed.
+    *         Object.errors {Array}: An { index, code, message } object per failed element.
+    *
+    * With chunkSize the results are formatted on a background thread and successCB is
+    * called once per chunk of at most chunkSize elements, with Object.offset giving the
+    * index of the chunk's first element and Object.done false, then once more with
+    * Object.done true. Error indexes count from the start of the whole array.
+    *
+    * @error GlobalizationError.PARSING_ERROR if the options are invalid
+    */
+    dateToStringBatch: function (dates, successCB, failureCB, options) {
+        var args;
+        if (isFloat64Array(dates)) {
+            argscheck.checkArgs('*fFO', 'Globalization.dateToStringBatch', arguments);
+            args = packedArgs('dates', dates, options);
+        } else {
+            argscheck.checkArgs('afFO', 'Globalization.dateToStringBatch', arguments);
+            args = {'dates': dates.map(function (date) { return date.valueOf(); }), 'options': options};
+        }
+        execBatch(successCB, failureCB, 'dateToStringBatch', args, options);
+    },
+
+    /**
+    * Formats an array of numbers with one set of options. Supported on BlackBerry 10 and
+    * Ubuntu. On BlackBerry 10 the numbers may also be a Float64Array, which reaches the
+    * native code packed instead of as JSON numbers.
+    *
+    * @param {Array|Float64Array} numbers
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            type {String}: 'decimal', "percent", or 'currency'
+    *            chunkSize {Number}: BlackBerry 10 only, streams the results as for
+    *            dateToStringBatch
+    *
+    * @return Object.value {Array}: The formatted numbers, null where an element failed.
+    *         Object.errors {Array}: An { index, code, message } object per failed element.
+    *
+    * @error GlobalizationError.PARSING_ERROR if the options are invalid
+    */
+    numberToStringBatch: function (numbers, successCB, failureCB, options) {
+        var args;
+        if (isFloat64Array(numbers)) {
+            argscheck.checkArgs('*fFO', 'Globalization.numberToStringBatch', arguments);
+            args = packedArgs('numbers', numbers, options);
+        } else {
+            argscheck.checkArgs('afFO', 'Globalization.numberToStringBatch', arguments);
+            args = {'numbers': numbers, 'options': options};
+        }
+        execBatch(successCB, failureCB, 'numberToStringBatch', args, options);
+    },
+
+    /**
+    * Parses an array of number strings with one set of options. Supported on
+    * BlackBerry 10 and Ubuntu.
+    *
+    * @param {Array} numberStrings
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    * @param {Object} options {optional}
+    *            type {String}: 'decimal', "percent", or 'currency'
+    *            chunkSize {Number}: BlackBerry 10 only, streams the results as for
+    *            dateToStringBatch
+    *
+    * @return Object.value {Array}: The parsed numbers, null where an element failed.
+    *         Object.errors {Array}: An { index, code, message } object per failed element.
+    *
+    * @error GlobalizationError.PARSING_ERROR if the options are invalid
+    */
+    stringToNumberBatch: function (numberStrings, successCB, failureCB, options) {
+        argscheck.checkArgs('afFO', 'Globalization.stringToNumberBatch', arguments);
+        execBatch(successCB, failureCB, 'stringToNumberBatch', {'numberStrings': numberStrings, 'options': options}, options);
+    },
+
+    /**
+    * Returns the statistics of the per-locale formatter cache. Supported on BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @return    Object.capacity {Number}: The maximum number of locales kept.
+    *            Object.locales {Number}: The number of locales currently cached.
+    *            Object.hits {Number}: Lookups served from the cache.
+    *            Object.misses {Number}: Lookups that created a new locale entry.
+    *            Object.evictions {Number}: Locales dropped to stay within the capacity.
+    *            Object.bytes {Number}: Approximate memory used by the cached locales.
+    *
+    * @error GlobalizationError.UNKNOWN_ERROR
+    */
+    getCacheStats: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.getCacheStats', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getCacheStats', []);
+    },
+
+    /**
+    * Sets how many locales the per-locale formatter cache keeps, evicting the least
+    * recently used ones beyond it. Supported on BlackBerry 10.
+    *
+    * @param {Number} capacity
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @return Object.value {Number}: The new capacity.
+    *
+    * @error GlobalizationError.PARSING_ERROR
+    */
+    setCacheCapacity: function (capacity, successCB, failureCB) {
+        argscheck.checkArgs('nfF', 'Globalization.setCacheCapacity', arguments);
+        exec(successCB, failureCB, 'Globalization', 'setCacheCapacity', [{'capacity': capacity}]);
+    },
+
+    /**
+    * Sets the years for which daylight savings transitions are precomputed per time zone.
+    * isDayLightSavingsTime answers dates inside the window by binary search and computes
+    * the others from the zone rules. The default window is 1970 to 2037. Supported on
+    * BlackBerry 10.
+    *
+    * @param {Number} firstYear
+    * @param {Number} lastYear
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @error GlobalizationError.PARSING_ERROR
+    */
+    setTransitionWindow: function (firstYear, lastYear, successCB, failureCB) {
+        argscheck.checkArgs('nnfF', 'Globalization.setTransitionWindow', arguments);
+        exec(successCB, failureCB, 'Globalization', 'setTransitionWindow', [{'firstYear': firstYear, 'lastYear': lastYear}]);
+    },
+
+    /**
+    * Returns call statistics for every command the native extension has run, keyed by
+    * command name. Latencies are in nanoseconds and percentiles are accurate to about
+    * 12%. Supported on BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @return    Object[command].count {Number}: The number of calls.
+    *            Object[command].errors {Number}: The number of calls that returned an error.
+    *            Object[command].mean_ns {Number}: The mean latency.
+    *            Object[command].p50_ns {Number}: The median latency.
+    *            Object[command].p90_ns {Number}: The 90th percentile latency.
+    *            Object[command].p99_ns {Number}: The 99th percentile latency.
+    *            Object[command].max_ns {Number}: The highest latency.
+    *
+    * @error GlobalizationError.UNKNOWN_ERROR if the extension was built without statistics
+    */
+    getStats: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.getStats', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getStats', []);
+    },
+
+    /**
+    * Returns how many native objects and browser contexts the extension holds, and
+    * how many released context registries it keeps for reuse. Supported on
+    * BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @return    Object.objects {Number}: The live native objects.
+    *            Object.contexts {Number}: The browser contexts with live objects.
+    *            Object.pooled {Number}: The registries kept for new contexts.
+    */
+    getObjectCounts: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.getObjectCounts', arguments);
+        exec(successCB, failureCB, 'Globalization', 'getObjectCounts', []);
+    },
+
+    /**
+    * Clears the statistics returned by getStats. Supported on BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    */
+    resetStats: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.resetStats', arguments);
+        exec(successCB, failureCB, 'Globalization', 'resetStats', []);
+    },
+
+    /**
+    * Clears the trace buffer and starts recording spans for native calls: the JNext
+    * entry point, command dispatch, JSON parsing and writing, ICU object construction
+    * and formatting. The buffer keeps the most recent 16384 spans. Supported on
+    * BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    */
+    startTrace: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.startTrace', arguments);
+        exec(successCB, failureCB, 'Globalization', 'startTrace', []);
+    },
+
+    /**
+    * Stops recording spans. Recorded spans are kept until the next startTrace.
+    * Supported on BlackBerry 10.
+    *
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    */
+    stopTrace: function (successCB, failureCB) {
+        argscheck.checkArgs('fF', 'Globalization.stopTrace', arguments);
+        exec(successCB, failureCB, 'Globalization', 'stopTrace', []);
+    },
+
+    /**
+    * Writes the recorded spans to a file as Chrome trace_event JSON, which can be
+    * opened in chrome://tracing or Perfetto. Supported on BlackBerry 10.
+    *
+    * @param {String} path
+    * @param {Function} successCB
+    * @param {Function} errorCB
+    *
+    * @return Object.value {Number}: The number of spans written.
+    *
+    * @error GlobalizationError.UNKNOWN_ERROR
+    */
+    dumpTrace: function (path, successCB, failureCB) {
+        argscheck.checkArgs('sfF', 'Globalization.dumpTrace', arguments);
+        exec(successCB, failureCB, 'Globalization', 'dumpTrace', [{'path': path}]);
     }
 
 };
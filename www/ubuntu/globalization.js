@@ -17,141 +17,112 @@
  *
 */
 
-/* global Cordova */
-
 var exec = require('cordova/exec');
 var argscheck = require('cordova/argscheck');
 var GlobalizationError = require('./GlobalizationError');
 
-function convertStringToDateOptions (override) {
-    var options = { formatLength: 'short', selector: 'date and time' };
-
-    if (override) {
-        for (var key in options) {
-            if (!options.hasOwnProperty(key)) { continue; }
-            if (typeof (options[key]) !== typeof (override[key])) { continue; }
-            options[key] = override[key];
-        }
-    }
-    var formats = ['short', 'medium', 'long', 'full'];
-    var selectors = ['date', 'time', 'date and time'];
-
-    options.formatLength = formats.indexOf(options.formatLength);
-    options.selector = selectors.indexOf(options.selector);
-    // TODO: throw error
-    if (options.formatLength === -1) { options.formatLength = 0; }
-    if (options.selector === -1) { options.selector = 0; }
-
-    return options;
+// The plugin reports failures as { code, message } objects.
+function errorCallback (failureCB) {
+    return failureCB && function (error) {
+        failureCB(new GlobalizationError(error.code, error.message));
+    };
 }
 
-function convertStringToNumberOptions (override) {
-    var options = { type: 'decimal' };
-    // TODO: make function
-    if (override) {
-        for (var key in options) {
-            if (!options.hasOwnProperty(key)) { continue; }
-            if (typeof (options[key]) !== typeof (override[key])) { continue; }
-            options[key] = override[key];
-        }
-    }
-
-    var types = [ 'decimal', 'percent', 'currency' ];
-    options.type = types.indexOf(options.type);
-    if (options.type === -1) { options.type = 0; }
-
-    return options;
-}
-
-function isInt (n) {
-    return n % 1 === 0;
+// Every call takes the same argument object as the shared engine the
+// BlackBerry 10 plugin uses; the plugin adds the device's locale and time
+// zone unless options name their own.
+function call (action, successCB, failureCB, args) {
+    exec(successCB, errorCallback(failureCB), 'Globalization', action, args ? [ args ] : []);
 }
 
 module.exports = {
-    isDayLightSavingsTime: function (date, successCB, failureCB) {
-        argscheck.checkArgs('dfF', 'Globalization.isDayLightSavingsTime', arguments);
+    getPreferredLanguage: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getPreferredLanguage', arguments);
+        call('getPreferredLanguage', successCB, failureCB, { options: options });
+    },
 
-        exec(successCB, failureCB, 'Globalization', 'isDayLightSavingsTime', [ { time_t: date.getTime() } ]);
+    getLocaleName: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getLocaleName', arguments);
+        call('getLocaleName', successCB, failureCB, { options: options });
     },
 
-    dateToString: function (date, successCB, failureCB, override) {
-        argscheck.checkArgs('dfFO', 'Globalization.dateToString', arguments);
+    isDayLightSavingsTime: function (date, successCB, failureCB, options) {
+        argscheck.checkArgs('dfFO', 'Globalization.isDayLightSavingsTime', arguments);
+        call('isDayLightSavingsTime', successCB, failureCB, { date: date.getTime(), options: options });
+    },
 
-        var options = convertStringToDateOptions(override);
-        exec(successCB, failureCB, 'Globalization', 'dateToString',
-            [ { time_t: date.getTime(), formatLength: options.formatLength, selector: options.selector } ]);
+    getFirstDayOfWeek: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getFirstDayOfWeek', arguments);
+        call('getFirstDayOfWeek', successCB, failureCB, { options: options });
+    },
 
+    dateToString: function (date, successCB, failureCB, options) {
+        argscheck.checkArgs('dfFO', 'Globalization.dateToString', arguments);
+        call('dateToString', successCB, failureCB, { date: date.getTime(), options: options });
     },
 
-    stringToDate: function (dateString, successCB, failureCB, override) {
+    stringToDate: function (dateString, successCB, failureCB, options) {
         argscheck.checkArgs('sfFO', 'Globalization.stringToDate', arguments);
+        call('stringToDate', successCB, failureCB, { dateString: dateString, options: options });
+    },
 
-        var options = convertStringToDateOptions(override);
-        exec(successCB, failureCB, 'Globalization', 'stringToDate',
-            [ { dateString: dateString, formatLength: options.formatLength, selector: options.selector } ]);
+    getDatePattern: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getDatePattern', arguments);
+        call('getDatePattern', successCB, failureCB, { options: options });
     },
 
-    getDateNames: function (successCB, failureCB, override) {
+    getDateNames: function (successCB, failureCB, options) {
         argscheck.checkArgs('fFO', 'Globalization.getDateNames', arguments);
-
-        var options = { type: 'wide', item: 'months' };
-
-        if (override) {
-            for (var key in options) {
-                if (!options.hasOwnProperty(key)) { continue; }
-                if (typeof (options[key]) !== typeof (override[key])) { continue; }
-                options[key] = override[key];
-            }
-        }
-
-        var requests = ['days', 'months'];
-        var formats = ['narrow', 'wide'];
-
-        options.item = requests.indexOf(options.item);
-        options.type = formats.indexOf(options.type);
-
-        // TODO: throw error
-        if (options.item === -1) { options.item = 0; }
-        if (options.type === -1) { options.type = 0; }
-
-        exec(successCB, failureCB, 'Globalization', 'getDateNames', [ options ]);
+        call('getDateNames', successCB, failureCB, { options: options });
     },
 
-    numberToString: function (number, successCB, failureCB, override) {
+    numberToString: function (number, successCB, failureCB, options) {
         argscheck.checkArgs('nfFO', 'Globalization.numberToString', arguments);
-
-        var options = convertStringToNumberOptions(override);
-
-        exec(successCB, failureCB, 'Globalization', 'numberToString',
-            [ { type: options.type, isInt: isInt(number), number: number } ]);
+        call('numberToString', successCB, failureCB, { number: number, options: options });
     },
 
-    stringToNumber: function (numberString, successCB, failureCB, override) {
+    stringToNumber: function (numberString, successCB, failureCB, options) {
         argscheck.checkArgs('sfFO', 'Globalization.stringToNumber', arguments);
+        call('stringToNumber', successCB, failureCB, { numberString: numberString, options: options });
+    },
 
-        var options = convertStringToNumberOptions(override);
-        exec(successCB, failureCB, 'Globalization', 'stringToNumber', [ options.type, numberString ]);
+    getNumberPattern: function (successCB, failureCB, options) {
+        argscheck.checkArgs('fFO', 'Globalization.getNumberPattern', arguments);
+        call('getNumberPattern', successCB, failureCB, { options: options });
     },
 
-    getDatePattern: function (successCB, failureCB, override) {
-        argscheck.checkArgs('fFO', 'Globalization.getDatePattern', arguments);
+    getCurrencyPattern: function (currencyCode, successCB, failureCB, options) {
+        argscheck.checkArgs('sfFO', 'Globalization.getCurrencyPattern', arguments);
+        call('getCurrencyPattern', successCB, failureCB, { currencyCode: currencyCode, options: options });
+    },
 
-        var options = convertStringToDateOptions(override);
-        exec(successCB, failureCB, 'Globalization', 'getDatePattern', [ options.formatLength, options.selector ]);
+    // The batch forms take an array and one set of options for all of its
+    // elements. successCB gets { value: [...], errors: [...] }: a result
+    // per element, null where one failed, and { index, code, message } in
+    // errors for each failure. Typed arrays go as plain arrays and results
+    // are not streamed here, chunkSize is ignored.
+    dateToStringBatch: function (dates, successCB, failureCB, options) {
+        argscheck.checkArgs('afFO', 'Globalization.dateToStringBatch', arguments);
+        var times = dates.map(function (date) { return date.getTime(); });
+        call('dateToStringBatch', successCB, failureCB, { dates: times, options: options });
     },
 
-    getNumberPattern: function (successCB, failureCB, override) {
-        argscheck.checkArgs('fFO', 'getNumberPattern', arguments);
+    numberToStringBatch: function (numbers, successCB, failureCB, options) {
+        argscheck.checkArgs('*fFO', 'Globalization.numberToStringBatch', arguments);
+        call('numberToStringBatch', successCB, failureCB, { numbers: Array.prototype.slice.call(numbers), options: options });
+    },
 
-        var options = convertStringToNumberOptions(override);
-        Cordova.exec(successCB, failureCB, 'Globalization', 'getNumberPattern', [ options.type ]);
+    stringToNumberBatch: function (numberStrings, successCB, failureCB, options) {
+        argscheck.checkArgs('afFO', 'Globalization.stringToNumberBatch', arguments);
+        call('stringToNumberBatch', successCB, failureCB, { numberStrings: numberStrings, options: options });
     },
 
-    getCurrencyPattern: function (currencyCode, successCB, failureCB) {
-        argscheck.checkArgs('sfF', 'Globalization.getCurrencyPattern', arguments);
+    // Runs the calls above on a pool of worker threads instead of the UI
+    // thread. Results still arrive in the order the calls were made.
+    setThreaded: function (threaded, successCB, failureCB) {
+        argscheck.checkArgs('*fF', 'Globalization.setThreaded', arguments);
 
-        failureCB(new GlobalizationError(GlobalizationError.PATTERN_ERROR, 'unimplemented'));
-        // exec(successCB, failureCB, "Globalization", "getCurrencyPattern", [{"currencyCode": currencyCode}]);
+        exec(successCB, errorCallback(failureCB), 'Globalization', 'setThreaded', [ !!threaded ]);
     }
 };
 